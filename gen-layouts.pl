@@ -29,7 +29,10 @@ sub usage {
   die "usage: $0 <option>\n".
     " -p    generate perl lists of permutes\n".
     " -d    generate C++ class definitions\n".
-    " -m    generate CPP layout/unlayout macros\n";
+    " -m    generate CPP layout/unlayout macros\n".
+    " -c <3d>:<4d> ...\n".
+    "       generate CPP macro listing the given pairs of 3-D and 4-D layouts,\n".
+    "       e.g., '-c 123:1234 321:1432'\n";
 }
 
 usage() if !defined $ARGV[0];
@@ -41,6 +44,28 @@ use File::Basename;
 use lib dirname($0)."/lib";
 use lib dirname($0)."/../lib";
 
+# layout choices.
+if ($opt eq '-c') {
+  my @choices;
+  for my $arg (@ARGV[1..$#ARGV]) {
+    for my $pair (split ' ', $arg) {
+      my ($l3, $l4) = map { s/^Layout_//; $_ } split /:/, $pair;
+      die "error: '$pair' is not a pair of 3-D and 4-D layouts, e.g., '123:1234'.\n"
+        if !defined $l4 ||
+        join('', sort split //, $l3) ne '123' ||
+        join('', sort split //, $l4) ne '1234';
+      my $choice = "fn(Layout_$l3, Layout_$l4)";
+      push @choices, $choice if !grep { $_ eq $choice } @choices;
+    }
+  }
+  die "error: no layouts given.\n" if !@choices;
+  print "// Automatically generated; do not edit.\n",
+    "\n// Apply macro 'fn' to each pair of 3-D and 4-D layout classes\n",
+    "// that may be selected at run-time.\n",
+    "#define LAYOUT_CHOICES(fn) ", join(' ', @choices), "\n";
+  exit 0;
+}
+
 print "// Automatically generated; do not edit.\n";
 print "#include <stddef.h>\n" if ($opt eq '-d');
 
@@ -160,9 +185,11 @@ for my $n (@sizes) {
       "  virtual void unlayout(idx_t ai, $uargs) const =0;\n",
       "};\n";
 
+    my @names;
     permute {
       my @p = @_;
       my $name = join('', @p);
+      push @names, "Layout_$name";
       my @jvars = map { "j$_" } @p;
       my @dvars = map { "_d$_" } @p;
       my $dims = join(', ', map { "d$_" } @p);
@@ -181,6 +208,9 @@ for my $n (@sizes) {
         "};\n";
 
     } @a;
+
+    print "\n// Apply macro 'fn' to each $n-D layout class.\n",
+      "#define LAYOUTS_${n}D(fn) ", join(' ', map { "fn($_)" } @names), "\n";
   }
 
   # just list permutes.
@@ -685,10 +685,10 @@ sub processCode($) {
                 # pipeline-priming loop.
                 if ($features & $bPipe) {
 
-                    # start the loop STENCIL_ORDER before 0.
-                    # TODO: make this more general.
+                    # prime at the iteration before 0; the calc
+                    # functions carry the pipeline forward from there.
                     push @code, " // Prime the calculation pipeline.";
-                    beginLoop(\@code, \@loopDims, \@loopPrefix, "-STENCIL_ORDER", 0, $features, \@loopStack);
+                    beginLoop(\@code, \@loopDims, \@loopPrefix, -1, 0, $features, \@loopStack);
 
                     # select only pipe instructions, change calc to prime prefix.
                     my @primeStmts = grep(m=//|$OPT{pipePrefix}=, @calcStmts);
@@ -861,7 +861,7 @@ sub main() {
       "  $script -dims x,y 'loop(x,y) { calc(f); }'\n",
       "  $script -dims x,y,z 'omp loop(x,y) { loop(z) { calc(f); } }'\n",
       "  $script -dims x,y,z 'omp loop(x,y) { prefetch loop(z) { calc(f); } }'\n",
-      #"  $script -dims x,y,z 'omp loop(x,y) { pipeline loop(z) { calc(f); } }'\n",
+      "  $script -dims x,y,z 'omp loop(x,y) { pipeline loop(z) { calc(f); } }'\n",
       "  $script -dims x,y,z 'omp loop(x) { serpentine loop(y,z) { calc(f); } }'\n",
       "  $script -dims x,y,z 'omp loop(x) { crew loop(y) { loop(z) { calc(f); } } }'\n",
       "Inner loops should contain calc statements that generate calls to calculation functions.\n",
@@ -875,7 +875,7 @@ sub main() {
       "  prefetch(L2):    generate calls to SW L2 prefetch functions in addition to calc functions.\n",
       "  serpentine:      generate reverse path when enclosing loop dimension is odd.\n",
       "  square_wave:     generate 2D square-wave path for two innermost dimensions of a collapsed loop.\n",
-      #"  pipeline:        generate calls to pipeline versions of calculation functions (deprecated).\n",
+      "  pipeline:        generate calls to pipeline versions of calculation functions.\n",
       "For each dim D in dims, loops are generated from begin_D to end_D-1 by step_D;\n",
       "  these vars must be defined outside of the generated code.\n",
       "Each iteration will cover values from start_D to stop_D-1;\n",
@@ -67,6 +67,17 @@ public:
         string str = "(*context." + pp.getName() + ")(" + pp.makeValStr() + ")";
         return str;
     }
+
+    // Fused multiply-adds via the real_t FMA functions.
+    // These are used to round the same way as the vector code.
+    virtual bool useFma() const { return true; }
+    virtual string makeFma(const string& a, const string& b, const string& c,
+                           bool negProd = false, bool negAddend = false) {
+        assert(!(negProd && negAddend));
+        string fn = negProd ? "real_fnmadd" :
+            negAddend ? "real_fmsub" : "real_fmadd";
+        return fn + "(" + a + ", " + b + ", " + c + ")";
+    }
     
     // Make call for a point.
     virtual string makePointCall(const GridPoint& gp,
@@ -85,6 +96,8 @@ public:
 
     // Update a grid point.
     virtual string writeToPoint(ostream& os, const GridPoint& gp, const string& val) {
+        if (gp.isParam())
+            return readFromParam(os, gp) + " = " + val;
         return makePointCall(gp, "writeElem", val);
     }
 };
@@ -94,6 +107,9 @@ public:
 // Output simple C++ vector code.
 class CppVecPrintHelper : public VecPrintHelper {
 
+protected:
+    bool _maskWrites;           // if true, write via masks in 'cmask'.
+
 public:
     CppVecPrintHelper(VecInfoVisitor& vv,
                       bool allowUnalignedLoads,
@@ -103,7 +119,13 @@ public:
                       const string& linePrefix,
                       const string& lineSuffix) :
         VecPrintHelper(vv, allowUnalignedLoads, cv,
-                       varPrefix, varType, linePrefix, lineSuffix) { }
+                       varPrefix, varType, linePrefix, lineSuffix),
+        _maskWrites(false) { }
+
+    // Generate writes for a partial cluster.
+    virtual void setMaskWrites(bool maskWrites) {
+        _maskWrites = maskWrites;
+    }
 
 protected:
 
@@ -122,7 +144,17 @@ protected:
         string str = "(*context." + pp.getName() + ")(" + pp.makeValStr() + ")";
         return str;
     }
-    
+
+    // Fused multiply-adds via the real_vec_t FMA functions.
+    virtual bool useFma() const { return true; }
+    virtual string makeFma(const string& a, const string& b, const string& c,
+                           bool negProd = false, bool negAddend = false) {
+        assert(!(negProd && negAddend));
+        string fn = negProd ? "real_vec_fnmadd" :
+            negAddend ? "real_vec_fmsub" : "real_vec_fmadd";
+        return fn + "(" + a + ", " + b + ", " + c + ")";
+    }
+
     // Print a comment about a point.
     virtual void printPointComment(ostream& os, const GridPoint& gp, const string& verb) const {
 
@@ -184,7 +216,30 @@ protected:
         printPointComment(os, gp, "Write aligned vector block to");
 
         // Write temp var to memory.
-        printPointCall(os, gp, "writeVecNorm", val, "__LINE__", true);
+        if (_maskWrites) {
+
+            // Mask is selected by the vector's position in the cluster.
+            ostringstream oss;
+            oss << val << ", cmask.get(";
+            int n = 0;
+            for (string dim : { "x", "y", "z" }) {
+                const int* op = gp.lookup(dim);
+                const int* fp = getFold().lookup(dim);
+                int ofs = op ? *op : 0;
+                int vlen = fp ? *fp : 1;
+                if (ofs < 0 || ofs % vlen) {
+                    cerr << "Error: cannot generate masked write to " <<
+                        gp.getName() << " at " << gp.makeDimValOffsetStr() << endl;
+                    exit(1);
+                }
+                if (n++) oss << ", ";
+                oss << (ofs / vlen);
+            }
+            oss << ")";
+            printPointCall(os, gp, "writeVecNormMasked", oss.str(), "__LINE__", true);
+        }
+        else
+            printPointCall(os, gp, "writeVecNorm", val, "__LINE__", true);
         os << ";" << endl;
         return val;
     }
@@ -273,8 +328,17 @@ public:
         else
             pfPts = &_vv._alignedVecs;
 
-        os << " const char* p = 0;" << endl;
+        // Partial sums are not in memory; get the points they read.
+        GridPointSet memPts;
         for (auto gp : *pfPts) {
+            if (isPartialSum(gp))
+                _partialSums->at(gp.getName()).getPoints(memPts, gp);
+            else
+                memPts.insert(gp);
+        }
+
+        os << " const char* p = 0;" << endl;
+        for (auto gp : memPts) {
             printPointComment(os, gp, "Aligned");
             
             // Prefetch memory.
@@ -285,6 +349,40 @@ public:
             os << " _mm_prefetch(p, level);" << endl;
         }
     }
+
+    // Print body of a pipeline-loading function.
+    // 'vecs' and 'srcs' are from VecInfoVisitor::getPipeline().
+    // If 'prime' is set, only read the vectors that the next non-priming
+    // call will shift. Otherwise, shift the vectors from the previous
+    // cluster and read or calculate the rest.
+    virtual void printPipeLoads(ostream& os, const vector<GridPoint>& vecs,
+                                const vector<int>& srcs, bool prime) {
+        set<int> shifted(srcs.begin(), srcs.end());
+        for (size_t i = 0; i < vecs.size(); i++) {
+            auto& gp = vecs[i];
+            int src = srcs[i];
+
+            // Nothing to do if it doesn't move or isn't needed yet.
+            if (prime ? !shifted.count(i) : src == int(i))
+                continue;
+
+            if (!prime && src >= 0) {
+                os << endl << " // Shift " << gp.getName() << " at " <<
+                    gp.makeDimValOffsetStr() << " from previous cluster." << endl;
+                os << " pipe.v[" << i << "] = pipe.v[" << src << "];" << endl;
+            }
+            else if (isPartialSum(gp)) {
+                string varName = printPartialSum(os, gp);
+                os << " pipe.v[" << i << "] = " << varName << ";" << endl;
+            }
+            else {
+                printPointComment(os, gp, "Read aligned vector block from");
+                os << " pipe.v[" << i << "] = ";
+                printPointCall(os, gp, "readVecNorm", "", "__LINE__", true);
+                os << ";" << endl;
+            }
+        }
+    }
 };
 
 // Print out a stencil in C++ form for YASK.
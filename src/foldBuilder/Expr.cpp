@@ -251,6 +251,65 @@ bool CommutativeExpr::isSame(const Expr* other) {
     return matches.size() == _ops.size();
 }
 
+// Structural hashes.
+// Mix 'v' into 'seed'.
+static size_t hashCombine(size_t seed, size_t v) {
+    return seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+size_t Expr::getHash(ExprHashes& hashes) const {
+    auto i = hashes.find(this);
+    if (i != hashes.end())
+        return i->second;
+    size_t h = makeHash(hashes);
+    hashes[this] = h;
+    return h;
+}
+size_t ConstExpr::makeHash(ExprHashes& hashes) const {
+    return hashCombine(1, hash<double>()(_f));
+}
+size_t CodeExpr::makeHash(ExprHashes& hashes) const {
+    return hashCombine(2, hash<string>()(_code));
+}
+size_t UnaryExpr::makeHash(ExprHashes& hashes) const {
+    size_t h = hashCombine(3, hash<string>()(_opStr));
+    return hashCombine(h, _rhs->getHash(hashes));
+}
+size_t BinaryExpr::makeHash(ExprHashes& hashes) const {
+    size_t h = hashCombine(4, hash<string>()(_opStr));
+    h = hashCombine(h, _lhs->getHash(hashes));
+    return hashCombine(h, _rhs->getHash(hashes));
+}
+size_t CommutativeExpr::makeHash(ExprHashes& hashes) const {
+
+    // Sum of operand hashes, so order doesn't matter.
+    size_t sum = 0;
+    for (auto op : _ops)
+        sum += hashCombine(0, op->getHash(hashes));
+    size_t h = hashCombine(5, hash<string>()(_opStr));
+    return hashCombine(h, sum);
+}
+size_t GridPoint::makeHash(ExprHashes& hashes) const {
+
+    // Dims may be in any order.
+    size_t sum = 0;
+    for (auto dim : getDims())
+        sum += hashCombine(hash<string>()(dim), hash<int>()(getVal(dim)));
+    size_t h = hashCombine(6, hash<string>()(getName()));
+    return hashCombine(h, sum);
+}
+size_t EqualsExpr::makeHash(ExprHashes& hashes) const {
+    size_t h = hashCombine(7, _lhs->getHash(hashes));
+    return hashCombine(h, _rhs->getHash(hashes));
+}
+
+// FMA pattern.
+CommutativeExpr* getFmaProduct(const ExprPtr& ep) {
+    auto p = dynamic_cast<CommutativeExpr*>(ep.get());
+    if (p && p->getOpStr() == MultExpr::opStr() && p->getOps().size() > 1)
+        return p;
+    return NULL;
+}
+
 
 // GridPoint methods.
 const string& GridPoint::getName() const {
@@ -278,19 +337,35 @@ string GridPoint::makeStr() const {
 }
 
 // Visit all expressions in all grids.
-void Grids::acceptToAll(ExprVisitor* ev) {
+void Grids::acceptToAll(ExprVisitor* ev, bool interior) {
     for (auto gp : *this) {
-        gp->acceptToAll(ev);
+        gp->acceptToAll(ev, interior);
     }
 }
 
 // Visit first expression in each grid.
-void Grids::acceptToFirst(ExprVisitor* ev) {
+void Grids::acceptToFirst(ExprVisitor* ev, bool interior) {
+    for (auto gp : *this) {
+        gp->acceptToFirst(ev, interior);
+    }
+}
+
+// Visit reference expression in each grid.
+void Grids::acceptToRef(ExprVisitor* ev) {
     for (auto gp : *this) {
-        gp->acceptToFirst(ev);
+        gp->acceptToRef(ev);
     }
 }
 
+// Determine whether any grid has interior versions of its expressions.
+bool Grids::hasInteriorExprs() const {
+    for (auto gp : *this) {
+        if (gp->getInteriorExprs().size())
+            return true;
+    }
+    return false;
+}
+
 // Make a readable string from an expression.
 string Expr::makeStr() const {
     ostringstream oss;
@@ -320,6 +395,14 @@ void Expr::accept(ExprVisitor* ev) const {
 
 // Separate grids into equations.
 void Equations::findEquations(Grids& allGrids, const string& targets) {
+    findGridDeps(allGrids);
+
+    // Group automatically if no targets are given.
+    if (targets.length() == 0) {
+        groupEquations(allGrids);
+        findEqDeps();
+        return;
+    }
 
     // Handle each key-value pair in targets string.
     ArgParser ap;
@@ -360,7 +443,18 @@ void Equations::findEquations(Grids& allGrids, const string& targets) {
                     }
 
                     // Add grid to equation.
+                    // All grids in an equation must share a sub-domain.
                     assert(ep);
+                    if (ep->grids.size() == 0)
+                        ep->subDomain = gp->getSubDomain();
+                    else if (ep->subDomain != gp->getSubDomain()) {
+                        cerr << "Error: grid '" << gname << "' cannot be in equation '" <<
+                            key << "' because its sub-domain (" <<
+                            gp->getSubDomain().makeStr() << ") differs from that of '" <<
+                            ep->grids[0]->getName() << "' (" << ep->subDomain.makeStr() <<
+                            ")." << endl;
+                        exit(1);
+                    }
                     ep->grids.push_back(gp);
                     _eqGrids.insert(gp);
                 }
@@ -386,7 +480,300 @@ void Equations::findEquations(Grids& allGrids, const string& targets) {
         // It has the name of the grid and just one grid.
         eq.name = gp->getName();
         eq.grids.push_back(gp);
+        eq.subDomain = gp->getSubDomain();
         _eqGrids.insert(gp);
     }
+    findEqDeps();
+}
+
+// Find the updated grids read by the equation of each grid.
+void Equations::findGridDeps(Grids& allGrids) {
+    for (auto gp : allGrids) {
+        if (gp->getExprs().size() == 0)
+            continue;
+
+        // Points read by this grid's equation.
+        Grids g1;
+        g1.push_back(gp);
+        CounterVisitor cv;
+        g1.acceptToFirst(&cv);
+
+        for (auto op : allGrids) {
+            if (op == gp || op->getExprs().size() == 0)
+                continue;
+            auto maxp = cv.getMaxPoints(op);
+            if (!maxp)
+                continue;
+
+            // Compare the latest step read to the step written.
+            // Grids w/o a time dim are updated in place, so any read
+            // is of the current result.
+            const int* wt = op->getExprs().begin()->first.lookup("t");
+            const int* rt = maxp->lookup("t");
+            if (!wt || !rt || *rt >= *wt)
+                _rawDeps[gp].insert(op);
+            else
+                _warDeps[gp].insert(op);
+        }
+    }
+}
+
+// Group grids into equations based on their dependencies.
+// A grid is evaluated after the grids whose results it reads from the
+// same step. It is also evaluated before the grids whose earlier steps it
+// reads, in case they share time slots, unless they read its earlier
+// steps, too; such pairs can only be evaluated together.
+// Grids at the same level with the same sub-domain share an equation.
+void Equations::groupEquations(Grids& allGrids) {
+    Grids ugrids;
+    map<Grid*, int> levels;
+    for (auto gp : allGrids)
+        if (gp->getExprs().size()) {
+            ugrids.push_back(gp);
+            levels[gp] = 0;
+        }
+
+    // Raise levels until all orderings are satisfied.
+    // A path can't be longer than the number of grids w/o a cycle.
+    for (size_t iter = 0; ; iter++) {
+        if (iter > ugrids.size()) {
+            cerr << "Error: circular dependency between updated grids; " <<
+                "use '-eq' to group them manually." << endl;
+            exit(1);
+        }
+        bool changed = false;
+        for (auto gp : ugrids) {
+            for (auto op : _rawDeps[gp])
+                if (levels[gp] <= levels[op]) {
+                    levels[gp] = levels[op] + 1;
+                    changed = true;
+                }
+            for (auto op : _warDeps[gp])
+                if (!_warDeps[op].count(gp) && levels[op] <= levels[gp]) {
+                    levels[op] = levels[gp] + 1;
+                    changed = true;
+                }
+        }
+        if (!changed)
+            break;
+    }
+    int maxLevel = 0;
+    for (auto gp : ugrids)
+        maxLevel = max(maxLevel, levels[gp]);
+
+    // Make equations.
+    for (int level = 0; level <= maxLevel; level++) {
+        size_t first = size();
+        for (auto gp : ugrids) {
+            if (levels[gp] != level)
+                continue;
+
+            // Find equation in this level with same sub-domain.
+            Equation* ep = 0;
+            for (size_t i = first; i < size(); i++)
+                if (at(i).subDomain == gp->getSubDomain()) {
+                    ep = &at(i);
+                    break;
+                }
+            if (!ep) {
+                Equation ne;
+                push_back(ne);
+                ep = &back();
+                ep->subDomain = gp->getSubDomain();
+            }
+            ep->grids.push_back(gp);
+            _eqGrids.insert(gp);
+        }
+    }
+
+    // Name each equation after the common prefix of its grids' names.
+    set<string> names;
+    for (size_t i = 0; i < size(); i++) {
+        auto& eq = at(i);
+        string name = eq.grids[0]->getName();
+        for (auto gp : eq.grids) {
+            const string& gname = gp->getName();
+            size_t n = 0;
+            while (n < name.length() && n < gname.length() && name[n] == gname[n])
+                n++;
+            name.resize(n);
+        }
+        while (name.length() && name[name.length() - 1] == '_')
+            name.resize(name.length() - 1);
+        if (name.length() == 0 || names.count(name))
+            name = "eq" + to_string(i);
+        names.insert(name);
+        eq.name = name;
+    }
 }
 
+// Find the dependencies between equations and check their order.
+void Equations::findEqDeps() {
+    for (size_t i = 0; i < size(); i++) {
+        auto& eq = at(i);
+        eq.deps.clear();
+        for (auto gp : eq.grids) {
+            for (auto op : _rawDeps[gp]) {
+                size_t j = 0;
+                while (j < size() &&
+                       find(at(j).grids.begin(), at(j).grids.end(), op) == at(j).grids.end())
+                    j++;
+                assert(j < size());
+                if (j >= i) {
+                    cerr << "Error: grid '" << gp->getName() << "' in equation '" <<
+                        eq.name << "' reads the step of grid '" << op->getName() <<
+                        "' being calculated by " <<
+                        (j == i ? "the same equation" : "later equation '" + at(j).name + "'") <<
+                        "." << endl;
+                    exit(1);
+                }
+                if (find(eq.deps.begin(), eq.deps.end(), at(j).name) == eq.deps.end())
+                    eq.deps.push_back(at(j).name);
+            }
+        }
+    }
+}
+
+
+// Find wavefront angles.
+// For each pair of equations where equation 'i' reads a grid updated by
+// equation 'j' with halo 'h' (in clusters), the regions must be shifted
+// as follows (shift 'a[k]' is applied just before evaluating equation 'k',
+// cyclically across time steps):
+// - Read-after-write: a[j+1] + ... + a[i] >= h, so values read by 'i'
+// have already been calculated by 'j'.
+// - Write-after-read: a[i+1] + ... + a[j] >= h, so values read by 'i'
+// have not yet been overwritten by 'j' in the next time step. This is
+// conservative when the written and read time slots are different.
+// When 'i' == 'j', the sum of all the shifts must be >= h.
+// Shifts are only increased, so one pass satisfies all constraints.
+void Equations::findAngles(const IntTuple& clusterPts) {
+    size_t ne = size();
+
+    // Halos read by each equation.
+    vector<CounterVisitor> cvs(ne);
+    for (size_t i = 0; i < ne; i++)
+        at(i).grids.acceptToFirst(&cvs[i]);
+
+    for (auto dim : clusterPts.getDims()) {
+        int pts = clusterPts.getVal(dim);
+        vector<int> a(ne, 0);
+
+        // Sum of shifts from 'first' through 'last', cyclically.
+        auto span = [&](size_t first, size_t last) {
+            int sum = 0;
+            for (size_t k = first % ne; ; k = (k + 1) % ne) {
+                sum += a[k];
+                if (k == last)
+                    break;
+            }
+            return sum;
+        };
+
+        for (size_t i = 0; i < ne; i++) {
+            for (size_t j = 0; j < ne; j++) {
+
+                // Max halo of grids updated by 'j' and read by 'i', in clusters.
+                int h = 0;
+                for (auto gp : at(j).grids)
+                    h = max(h, cvs[i].getHalo(gp, dim));
+                h = (h + pts - 1) / pts;
+                if (!h)
+                    continue;
+
+                if (i == j) {
+                    int s = span(0, ne - 1);
+                    if (s < h)
+                        a[i] += h - s;
+                } else {
+                    int raw = span(j + 1, i);
+                    if (raw < h)
+                        a[i] += h - raw;
+                    int war = span(i + 1, j);
+                    if (war < h)
+                        a[j] += h - war;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < ne; i++)
+            at(i).angles.addDim(dim, a[i] * pts);
+    }
+}
+
+// Find time slots.
+// The step being written and all the steps read must be in different
+// slots, except that the oldest step read may share the slot of the step
+// being written if it is only read by equations evaluated earlier in the
+// same step or by the grid's own equation at the same point. Example:
+// a grid whose equation reads t at any points and t-1 only at the same
+// point to write t+1 needs 2 slots.
+void Equations::findTimeSlots(Grids& allGrids) {
+
+    // Points read by each updated grid and the index of its equation.
+    map<Grid*, CounterVisitor> cvs;
+    map<Grid*, size_t> eqIndices;
+    for (size_t i = 0; i < size(); i++)
+        for (auto gp : at(i).grids) {
+            Grids g1;
+            g1.push_back(gp);
+            g1.acceptToFirst(&cvs[gp]);
+            eqIndices[gp] = i;
+        }
+
+    for (auto gp : allGrids) {
+        if (!gp->lookup("t"))
+            continue;
+
+        // Range of steps read.
+        bool isRead = false;
+        int minT = 0, maxT = 0;
+        for (auto& ci : cvs) {
+            auto pts = ci.second.getAllPoints(gp);
+            if (!pts)
+                continue;
+            for (auto& pt : *pts) {
+                int t = pt.getVal("t");
+                minT = isRead ? min(minT, t) : t;
+                maxT = isRead ? max(maxT, t) : t;
+                isRead = true;
+            }
+        }
+
+        // Not updated: need all steps read.
+        if (!eqIndices.count(gp)) {
+            gp->setTimeSlots(isRead ? maxT - minT + 1 : 1);
+            continue;
+        }
+
+        // Updated: need step written through oldest step read.
+        int wt = gp->getExprs().begin()->first.getVal("t");
+        if (!isRead || minT > wt)
+            minT = wt;
+        int slots = wt - minT + 1;
+
+        // Can the oldest step share the slot of the step being written?
+        if (minT < wt) {
+            bool share = true;
+            for (auto& ci : cvs) {
+                auto pts = ci.second.getAllPoints(gp);
+                if (!pts)
+                    continue;
+                for (auto& pt : *pts) {
+                    if (pt.getVal("t") != minT)
+                        continue;
+                    if (ci.first == gp) {
+                        for (auto dim : pt.getDims())
+                            if (dim != "t" && pt.getVal(dim) != 0)
+                                share = false;
+                    }
+                    else if (eqIndices[ci.first] >= eqIndices[gp])
+                        share = false;
+                }
+            }
+            if (share)
+                slots--;
+        }
+        gp->setTimeSlots(slots);
+    }
+}
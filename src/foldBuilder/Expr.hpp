@@ -30,6 +30,7 @@ IN THE SOFTWARE.
 
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include <cstdarg>
 #include <assert.h>
@@ -53,6 +54,9 @@ class Grid;
 class GridPoint;
 typedef shared_ptr<GridPoint> GridPointPtr;
 
+// Structural hashes of expression nodes, keyed by node.
+typedef unordered_map<const Expr*, size_t> ExprHashes;
+
 // The base class for all expression nodes.
 class Expr {
 public:
@@ -65,6 +69,12 @@ public:
     // Check for equivalency.
     virtual bool isSame(const Expr* other) =0;
 
+    // Return a hash of the structure of this expr.
+    // Exprs that are the same have the same hash.
+    // Hashes of nodes already visited are cached in 'hashes',
+    // so each node in a DAG is hashed only once.
+    size_t getHash(ExprHashes& hashes) const;
+
     // Return a simple string expr.
     virtual string makeStr() const;
 
@@ -73,6 +83,10 @@ public:
 
     // Create a deep copy of this expression.
     virtual ExprPtr clone() const =0;
+
+    // Calculate the hash of this node, using 'hashes' for sub-exprs.
+    // Use getHash() instead.
+    virtual size_t makeHash(ExprHashes& hashes) const =0;
 };
 typedef vector<ExprPtr> ExprPtrVec;
 
@@ -139,6 +153,7 @@ public:
         auto p = dynamic_cast<const ConstExpr*>(other);
         return p && _f == p->_f;
     }
+    virtual size_t makeHash(ExprHashes& hashes) const;
    
     // Create a deep copy of this expression.
     virtual ExprPtr clone() const { return make_shared<ConstExpr>(*this); }
@@ -167,6 +182,7 @@ public:
         auto p = dynamic_cast<const CodeExpr*>(other);
         return p && _code == p->_code;
     }
+    virtual size_t makeHash(ExprHashes& hashes) const;
 
     // Create a deep copy of this expression.
     virtual ExprPtr clone() const { return make_shared<CodeExpr>(*this); }
@@ -197,6 +213,7 @@ public:
         return p && _opStr == p->_opStr &&
             _rhs->isSame(p->_rhs.get());
     }
+    virtual size_t makeHash(ExprHashes& hashes) const;
 
     // Create a deep copy of this expression.
     virtual ExprPtr clone() const { return make_shared<UnaryExpr>(*this); }
@@ -243,6 +260,7 @@ public:
             _lhs->isSame(p->_lhs.get()) &&
             _rhs->isSame(p->_rhs.get());
     }
+    virtual size_t makeHash(ExprHashes& hashes) const;
 
     // Create a deep copy of this expression.
     virtual ExprPtr clone() const { return make_shared<BinaryExpr>(*this); }
@@ -338,6 +356,7 @@ public:
 
     // Check for equivalency.
     virtual bool isSame(const Expr* other);
+    virtual size_t makeHash(ExprHashes& hashes) const;
 
     // Create a deep copy of this expression.
     virtual ExprPtr clone() const { return make_shared<CommutativeExpr>(*this); }
@@ -379,6 +398,10 @@ public:
     virtual ExprPtr clone() const { return make_shared<MultExpr>(*this); } 
 };
 
+// Return 'ep' as a product that may be fused with an addition or
+// subtraction into an FMA, or NULL if it is not a product.
+CommutativeExpr* getFmaProduct(const ExprPtr& ep);
+
 // One specific point in a grid.
 // This is an expression leaf-node.
 class GridPoint : public IntTuple, public Expr {
@@ -431,6 +454,7 @@ public:
         auto p = dynamic_cast<const GridPoint*>(other);
         return p && *this == *p;
     }
+    virtual size_t makeHash(ExprHashes& hashes) const;
     
     // Determine whether this is 'ahead of' rhs in given direction.
     virtual bool isAheadOfInDir(const GridPoint& rhs, const IntTuple& dir) const;
@@ -469,6 +493,7 @@ public:
 
     // Check for equivalency.
     virtual bool isSame(const Expr* other);
+    virtual size_t makeHash(ExprHashes& hashes) const;
 
     // Create a deep copy of this expression.
     virtual ExprPtr clone() const { return make_shared<EqualsExpr>(*this); }
@@ -487,6 +512,66 @@ typedef map<GridPoint, ExprPtr> Point2Exprs;
 // to allow modification or conditional testing, etc.
 typedef const int GridIndex;
 
+// A box within the overall problem domain where an equation is
+// evaluated, e.g., a boundary slab. In each spatial dim, the box spans
+// [begin, end). Each bound is an offset from the first point of the
+// overall domain or, if 'fromEnd' is set, from one past its last point.
+// Dims that are not restricted span the whole domain.
+class SubDomain {
+public:
+    struct Bound {
+        int ofs;
+        bool fromEnd;
+        bool operator==(const Bound& rhs) const {
+            return ofs == rhs.ofs && fromEnd == rhs.fromEnd;
+        }
+    };
+
+protected:
+    map<string, pair<Bound, Bound>> _bounds; // begin & end in each restricted dim.
+
+public:
+
+    // Restrict dim to [begin, end) relative to the first point.
+    SubDomain& box(const string& dim, int begin, int end) {
+        _bounds[dim] = make_pair(Bound { begin, false }, Bound { end, false });
+        return *this;
+    }
+
+    // Restrict dim to the first 'width' points.
+    SubDomain& lowSlab(const string& dim, int width) {
+        _bounds[dim] = make_pair(Bound { 0, false }, Bound { width, false });
+        return *this;
+    }
+
+    // Restrict dim to the last 'width' points.
+    SubDomain& highSlab(const string& dim, int width) {
+        _bounds[dim] = make_pair(Bound { width, true }, Bound { 0, true });
+        return *this;
+    }
+
+    // Accessors.
+    bool isWhole() const { return _bounds.size() == 0; }
+    const map<string, pair<Bound, Bound>>& getBounds() const { return _bounds; }
+    bool operator==(const SubDomain& rhs) const { return _bounds == rhs._bounds; }
+    bool operator!=(const SubDomain& rhs) const { return !operator==(rhs); }
+
+    // Make a human-readable description.
+    string makeStr() const {
+        if (isWhole())
+            return "whole domain";
+        ostringstream oss;
+        int n = 0;
+        for (auto& i : _bounds) {
+            if (n++) oss << ", ";
+            oss << i.first << " in [" <<
+                (i.second.first.fromEnd ? "end-" : "") << i.second.first.ofs << ", " <<
+                (i.second.second.fromEnd ? "end-" : "") << i.second.second.ofs << ")";
+        }
+        return oss.str();
+    }
+};
+
 // A class for a collection of GridPoints.
 // Dims in the IntTuple describe the grid or param.
 // For grids, values in the IntTuple are ignored.
@@ -508,6 +593,29 @@ protected:
     // equation(s) describing how values in this grid are computed.
     Point2Exprs _exprs;
 
+    // Value of this grid in the interior of the domain, if any, e.g.,
+    // 1.0 for a sponge-layer coefficient.
+    bool _hasInteriorVal;
+    double _interiorVal;
+
+    // equation(s) for the interior of the domain, if different.
+    Point2Exprs _interiorExprs;
+
+    // Where the equation(s) are evaluated.
+    SubDomain _subDomain;
+
+    // Number of time-step slots to allocate if this grid has a time dim.
+    int _timeSlots;
+
+    // Equation for values computed once before the time steps, if any,
+    // e.g., for a coefficient derived from time-invariant grids.
+    ExprPtr _derivedExpr;
+
+    // Copy of the first equation saved before sub-exprs are moved into
+    // derived grids, if any. Used for the reference code, so validation
+    // compares against values computed without them.
+    ExprPtr _refExpr;
+
     // Add a new point if needed and return pointer to it.
     // If it already exists, just return pointer.
     virtual GridPointPtr addPoint(GridPointPtr gpp) {
@@ -516,7 +624,7 @@ protected:
     }
 
 public:
-    Grid() { }
+    Grid() : _hasInteriorVal(false), _interiorVal(0.0), _timeSlots(1) { }
     virtual ~Grid() { }
 
     // Name accessors.
@@ -527,6 +635,44 @@ public:
     bool isParam() const { return _isParam; }
     void setParam(bool isParam) { _isParam = isParam; }
     
+    // Whether this grid has only one dim, and it is spatial.
+    // Such grids are broadcast across the other dims when vectorized.
+    bool is1dSpatial() const {
+        return size() == 1 &&
+            (lookup("x") || lookup("y") || lookup("z"));
+    }
+
+    // Interior-value accessors.
+    bool hasInteriorValue() const { return _hasInteriorVal; }
+    double getInteriorValue() const { return _interiorVal; }
+    void setInteriorValue(double val) {
+        _hasInteriorVal = true;
+        _interiorVal = val;
+    }
+
+    // Sub-domain accessors.
+    const SubDomain& getSubDomain() const { return _subDomain; }
+    void setSubDomain(const SubDomain& sd) { _subDomain = sd; }
+
+    // Time-slot accessors.
+    int getTimeSlots() const { return _timeSlots; }
+    void setTimeSlots(int n) { _timeSlots = n; }
+
+    // Derived-value accessors.
+    bool isDerived() const { return _derivedExpr != NULL; }
+    const ExprPtr& getDerivedExpr() const { return _derivedExpr; }
+    ExprPtr& getDerivedExpr() { return _derivedExpr; }
+    void setDerivedExpr(ExprPtr ep) { _derivedExpr = ep; }
+
+    // Reference-expression accessors.
+    const ExprPtr& getRefExpr() const { return _refExpr; }
+    void saveRefExpr() {
+        for (auto i : _exprs) {
+            _refExpr = i.second->clone();
+            break;
+        }
+    }
+
     // Point accessors.
     const GridPointPtrSet& getPoints() const { return _points; }
     GridPointPtrSet& getPoints() { return _points; }
@@ -543,24 +689,43 @@ public:
     virtual Point2Exprs& getExprs() {
         return _exprs;
     }
+    virtual const Point2Exprs& getInteriorExprs() const {
+        return _interiorExprs;
+    }
+    virtual Point2Exprs& getInteriorExprs() {
+        return _interiorExprs;
+    }
+
+    // Get the interior expressions if they exist; otherwise the normal ones.
+    virtual Point2Exprs& getExprs(bool interior) {
+        return (interior && _interiorExprs.size()) ? _interiorExprs : _exprs;
+    }
     
     // Visit all expressions, if any are defined.
-    virtual void acceptToAll(ExprVisitor* ev) {
-        for (auto i : _exprs) {
+    virtual void acceptToAll(ExprVisitor* ev, bool interior = false) {
+        for (auto i : getExprs(interior)) {
             auto ep = i.second;
             ep->accept(ev);
         }
     }
     
     // Visit only first expression, if it is defined.
-    virtual void acceptToFirst(ExprVisitor* ev) {
-        for (auto i : _exprs) {
+    virtual void acceptToFirst(ExprVisitor* ev, bool interior = false) {
+        for (auto i : getExprs(interior)) {
             auto ep = i.second;
             ep->accept(ev);
             break;
         }
     }
 
+    // Visit reference expression if it was saved; otherwise the first one.
+    virtual void acceptToRef(ExprVisitor* ev) {
+        if (_refExpr)
+            _refExpr->accept(ev);
+        else
+            acceptToFirst(ev);
+    }
+
     // Create an expression to a specific point in the grid.
     // Note that this doesn't actually 'read' or 'write' a value;
     // it's just a node in an expression.
@@ -630,11 +795,17 @@ class Grids : public vector<Grid*> {
 public:
 
     // Visit all expressions in all grids.
-    virtual void acceptToAll(ExprVisitor* ev);
+    // If interior is true, visit interior versions where they exist.
+    virtual void acceptToAll(ExprVisitor* ev, bool interior = false);
 
     // Visit first expression in each grid.
-    virtual void acceptToFirst(ExprVisitor* ev);
+    virtual void acceptToFirst(ExprVisitor* ev, bool interior = false);
+
+    // Visit reference expression in each grid.
+    virtual void acceptToRef(ExprVisitor* ev);
 
+    // Determine whether any grid has interior versions of its expressions.
+    virtual bool hasInteriorExprs() const;
 };
 
 // Aliases for parameters.
@@ -647,20 +818,38 @@ typedef Grids Params;
 struct Equation {
     string name;
     Grids grids;
+    SubDomain subDomain;        // same for all grids.
+    IntTuple angles;            // wavefront shift before this equation, in points.
+    vector<string> deps;        // equations whose results from the same step are read.
 };
 
 // Equations:
 class Equations : public vector<Equation> {
 protected:
     set<Grid*> _eqGrids;        // all grids with equations.
+    bool _fuse;                 // evaluate all equations in each region.
+    bool _semiStencil;          // use partial sums along folded dims.
+
+    // Updated grids read by the equation of each grid, excluding itself.
+    // '_rawDeps' are read at the step being written by the other grid;
+    // '_warDeps' are only read at earlier steps.
+    map<Grid*, set<Grid*>> _rawDeps, _warDeps;
+
+    void findGridDeps(Grids& allGrids);
+    void groupEquations(Grids& allGrids);
+    void findEqDeps();
     
 public:
-    Equations() {}
+    Equations() : _fuse(false), _semiStencil(false) {}
     virtual ~Equations() {}
 
     // Separate a set of grids into equations based
     // on the target string.
-    // Target string is a comma-separated list of key-value pairs, e.g.,
+    // If the target string is empty, the grouping is derived from the
+    // dependencies between grids: grids whose updates don't read each
+    // other's results are put in the same equation, and equations are
+    // ordered so that results are calculated before they are read.
+    // Otherwise, the target string is a comma-separated list of key-value pairs, e.g.,
     // "equation1=foo,equation2=bar".
     // In this example, all grids with names containing 'foo' go in equation1,
     // all grids with names containing 'bar' go in equation2, and
@@ -669,6 +858,25 @@ public:
     void findEquations(Grids& allGrids, const string& targets);
 
     const set<Grid*>& getEqGrids() const { return _eqGrids; }
+
+    // Whether the kernel should evaluate all equations in each region
+    // instead of one equation at a time over the whole rank.
+    bool getFuse() const { return _fuse; }
+    void setFuse(bool fuse) { _fuse = fuse; }
+
+    // Whether to use partial sums of aligned vectors in vector code.
+    bool getSemiStencil() const { return _semiStencil; }
+    void setSemiStencil(bool semi) { _semiStencil = semi; }
+
+    // Find the spatial shift needed before evaluating each equation in a
+    // temporal wavefront, based on the halos of the grids each equation
+    // reads that are updated by other equations (or itself). Shifts are
+    // multiples of 'clusterPts', the points in a cluster in each dim.
+    void findAngles(const IntTuple& clusterPts);
+
+    // Find the number of time-step slots needed by each grid in
+    // 'allGrids' that has a time dim.
+    void findTimeSlots(Grids& allGrids);
     
     void printInfo(ostream& os) const {
         os << "Identified stencil equations:" << endl;
@@ -677,6 +885,20 @@ public:
                 os << "  Equation '" << eq.name << "' updates grid '" <<
                     gp->getName() << "'." << endl;
             }
+            if (!eq.subDomain.isWhole())
+                os << "  Equation '" << eq.name << "' is restricted to " <<
+                    eq.subDomain.makeStr() << "." << endl;
+            if (eq.angles.size())
+                os << "  Equation '" << eq.name << "' has wavefront angles " <<
+                    eq.angles.makeDimValStr(", ") << "." << endl;
+        }
+        os << "Equation schedule:" << endl;
+        for (size_t i = 0; i < size(); i++) {
+            auto& eq = at(i);
+            os << "  " << (i + 1) << ". '" << eq.name << "'";
+            for (size_t j = 0; j < eq.deps.size(); j++)
+                os << (j ? ", '" : " after '") << eq.deps[j] << "'";
+            os << "." << endl;
         }
     }
 
@@ -58,6 +58,9 @@ public:
 // A visitor that combines commutative exprs.
 // Example: (a + b) + c => a + b + c;
 class CombineVisitor : public OptVisitor {
+protected:
+    set<Expr*> _done;           // nodes already combined.
+
 public:
     CombineVisitor()  :
         OptVisitor("commutative recombination") {}
@@ -68,6 +71,11 @@ public:
     }
     
     virtual void visit(CommutativeExpr* ce) {
+
+        // Visit shared nodes only once.
+        if (_done.count(ce))
+            return;
+        _done.insert(ce);
         ExprPtrVec& ops = ce->getOps();
 
         // Visit ops first (depth-first).
@@ -75,44 +83,502 @@ public:
             ep->accept(this);
         }
 
-        // Repeat until no changes.
+        // Replace each op that is a commutative expr with the same
+        // operator with its operands. The ops were visited above, so
+        // their own ops are already combined, and one pass is enough.
+        // The operands are moved w/o cloning so that shared sub-exprs
+        // remain shared.
         auto opstr = ce->getOpStr();
-        bool done = false;
-        while (!done) {
-            done = true;        // assume done until change is made.
-        
-            // Scan elements of expr for more exprs of same type.
-            for (size_t i = 0; i < ops.size(); i++) {
-                ExprPtr& ep = ops[i];
-                auto ce2 = dynamic_pointer_cast<CommutativeExpr>(ep);
+        ExprPtrVec nops;
+        for (auto ep : ops) {
+            auto ce2 = dynamic_pointer_cast<CommutativeExpr>(ep);
 
-                // Is ep also a commutative expr with same operator?
-                if (ce2 && ce2->getOpStr() == opstr) {
+            // Is ep also a commutative expr with same operator?
+            if (ce2 && ce2->getOpStr() == opstr) {
+                for (auto op2 : ce2->getOps())
+                    nops.push_back(op2);
+                _numChanges++;
+            }
+            else
+                nops.push_back(ep);
+        }
+        ops.swap(nops);
+    }
+    
+};
+
+
+// A visitor that replaces points in grids that have interior values
+// with those values and then removes the resulting identity operations.
+// Example: (a + b) * sponge => a + b when sponge is 1.0 in the interior.
+// Must be applied to a copy of the expressions because it modifies them.
+class InteriorVisitor : public OptVisitor {
+protected:
+
+    // Return true if ep is a constant with value v.
+    static bool isConst(const ExprPtr& ep, double v) {
+        auto cp = dynamic_pointer_cast<ConstExpr>(ep);
+        return cp && cp->getVal() == v;
+    }
+
+    // Replace ep with a simpler expression if possible.
+    virtual void simplify(ExprPtr& ep) {
+
+        // Point in grid w/interior value.
+        auto gpp = dynamic_pointer_cast<GridPoint>(ep);
+        if (gpp) {
+            if (gpp->getGrid()->hasInteriorValue()) {
+                ep = constGridValue(gpp->getGrid()->getInteriorValue());
+                _numChanges++;
+            }
+            return;
+        }
 
-                    // Delete the existing operand.
+        // Remove 1.0 from products and 0.0 from sums.
+        auto ce = dynamic_pointer_cast<CommutativeExpr>(ep);
+        if (ce) {
+            double ident;
+            if (ce->getOpStr() == MultExpr::opStr())
+                ident = 1.0;
+            else if (ce->getOpStr() == AddExpr::opStr())
+                ident = 0.0;
+            else
+                return;
+            ExprPtrVec& ops = ce->getOps();
+            for (size_t i = 0; i < ops.size(); ) {
+                if (ops.size() > 1 && isConst(ops[i], ident))
                     ops.erase(ops.begin() + i);
+                else
+                    i++;
+            }
+            if (ops.size() == 1)
+                ep = ops[0];
+            return;
+        }
+
+        // Remove division by 1.0.
+        auto de = dynamic_pointer_cast<DivExpr>(ep);
+        if (de && isConst(de->getRhs(), 1.0))
+            ep = de->getLhs();
+    }
+
+public:
+    InteriorVisitor() :
+        OptVisitor("interior-value substitution") {}
+    virtual ~InteriorVisitor() {}
+
+    virtual void visit(UnaryExpr* ue) {
+        ue->getRhs()->accept(this);
+        simplify(ue->getRhs());
+    }
+    virtual void visit(BinaryExpr* be) {
+        be->getLhs()->accept(this);
+        simplify(be->getLhs());
+        be->getRhs()->accept(this);
+        simplify(be->getRhs());
+    }
+    virtual void visit(CommutativeExpr* ce) {
+        for (auto& ep : ce->getOps()) {
+            ep->accept(this);
+            simplify(ep);
+        }
+    }
+
+    // Only the RHS is changed.
+    virtual void visit(EqualsExpr* ee) {
+        ee->getRhs()->accept(this);
+        simplify(ee->getRhs());
+    }
+};
+
+// A visitor that moves each grid point by the negation of the given
+// offsets, e.g., to make an expr relative to the point it defines.
+class ShiftVisitor : public ExprVisitor {
+protected:
+    IntTuple _ofs;
+
+public:
+    ShiftVisitor(const IntTuple& ofs) : _ofs(ofs) {}
+    virtual ~ShiftVisitor() {}
+
+    virtual void visit(GridPoint* gp) {
+        if (gp->isParam())
+            return;
+        for (auto dim : _ofs.getDims()) {
+            if (gp->lookup(dim))
+                gp->setVal(dim, gp->getVal(dim) - _ofs.getVal(dim));
+        }
+    }
+};
+
+// A visitor that replaces the RHS of each equation w/a copy that has
+// new non-leaf nodes, so that the copy may be changed w/o changing
+// exprs shared w/other equations by CSE. Nodes shared within the
+// visited equations are copied once, so they remain shared. Leaf nodes
+// are not copied.
+class CopyVisitor : public ExprVisitor {
+protected:
+    map<Expr*, ExprPtr> _copies; // copy of each node.
+
+    // Return a copy of 'ep'.
+    virtual ExprPtr copy(const ExprPtr& ep) {
+        auto ci = _copies.find(ep.get());
+        if (ci != _copies.end())
+            return ci->second;
+        ExprPtr cp = ep;
+        auto be = dynamic_pointer_cast<BinaryExpr>(ep);
+        auto ue = dynamic_pointer_cast<UnaryExpr>(ep);
+        auto ce = dynamic_pointer_cast<CommutativeExpr>(ep);
+        if (be)
+            cp = make_shared<BinaryExpr>(copy(be->getLhs()), be->getOpStr(),
+                                         copy(be->getRhs()));
+        else if (ue)
+            cp = make_shared<UnaryExpr>(ue->getOpStr(), copy(ue->getRhs()));
+        else if (ce) {
+            auto cce = make_shared<CommutativeExpr>(ce->getOpStr());
+            for (auto& op : ce->getOps())
+                cce->getOps().push_back(copy(op));
+            cp = cce;
+        }
+        _copies[ep.get()] = cp;
+        return cp;
+    }
+
+public:
+    CopyVisitor() {}
+    virtual ~CopyVisitor() {}
+
+    // Only the RHS is changed.
+    virtual void visit(EqualsExpr* ee) {
+        ee->getRhs() = copy(ee->getRhs());
+    }
+};
+
+// Base class for visitors that replace sub-exprs w/reads of derived
+// grids or params, whose values are computed once before the time steps.
+// Derived grids and params are owned by this visitor and must be added
+// to the grids or params by the caller.
+class DerivedVisitor : public OptVisitor {
+protected:
+    const Grids& _grids;        // existing grids.
+    const Params& _params;      // existing params.
+    string _prefix;             // prefix of derived names.
+    vector<shared_ptr<Grid>> _derived; // derived grids or params created.
+    int _numNames;              // derived names tried.
+
+    // Make a name for a new derived grid or param that isn't used by
+    // another grid or param.
+    virtual string makeName() {
+        while (true) {
+            string name = _prefix + to_string(++_numNames);
+            bool found = false;
+            for (auto gp : _grids)
+                if (gp->getName() == name)
+                    found = true;
+            for (auto pp : _params)
+                if (pp->getName() == name)
+                    found = true;
+            if (!found)
+                return name;
+        }
+    }
+
+    // Return whether the value at 'gpp' may be computed before the time
+    // steps. Add to 'numReads' if it should be counted as a read.
+    virtual bool isInvariantPoint(const GridPointPtr& gpp, int& numReads) const =0;
+
+    // Return whether 'ep' reads only invariant points and constants.
+    // Add number of reads to 'numReads' and set 'hasDiv' if it contains
+    // a division.
+    virtual bool isInvariant(const ExprPtr& ep, int& numReads, bool& hasDiv) const {
+        if (dynamic_pointer_cast<ConstExpr>(ep))
+            return true;
+        auto gpp = dynamic_pointer_cast<GridPoint>(ep);
+        if (gpp)
+            return isInvariantPoint(gpp, numReads);
+        auto be = dynamic_pointer_cast<BinaryExpr>(ep);
+        if (be) {
+            if (be->getOpStr() == DivExpr::opStr())
+                hasDiv = true;
+            return isInvariant(be->getLhs(), numReads, hasDiv) &&
+                isInvariant(be->getRhs(), numReads, hasDiv);
+        }
+        auto ue = dynamic_pointer_cast<UnaryExpr>(ep);
+        if (ue)
+            return isInvariant(ue->getRhs(), numReads, hasDiv);
+        auto ce = dynamic_pointer_cast<CommutativeExpr>(ep);
+        if (ce) {
+            for (auto op : ce->getOps())
+                if (!isInvariant(op, numReads, hasDiv))
+                    return false;
+            return true;
+        }
+
+        // Code may read anything.
+        return false;
+    }
+
+    // Return a derived grid or param w/'dims' and values defined by
+    // 'dep'. Reuse one w/the same values if there is one.
+    virtual Grid* getDerived(const IntTuple& dims, bool isParam, const ExprPtr& dep) {
+        for (auto dg : _derived) {
+            auto ee = dynamic_pointer_cast<EqualsExpr>(dg->getDerivedExpr());
+            if (dg->isParam() == isParam && ee->getRhs()->isSame(dep.get()))
+                return dg.get();
+        }
+
+        // Make a new one.
+        auto dg = make_shared<Grid>();
+        dg->setName(makeName());
+        dg->setParam(isParam);
+        for (auto dim : dims.getDims())
+            dg->addDim(dim, dims.getVal(dim));
+        auto lhs = make_shared<GridPoint>(dg.get(), *dg);
+        dg->setDerivedExpr(make_shared<EqualsExpr>(lhs, dep));
+        _derived.push_back(dg);
+        return dg.get();
+    }
+
+public:
+    DerivedVisitor(const string& name, const string& prefix,
+                   const Grids& grids, const Params& params) :
+        OptVisitor(name), _grids(grids), _params(params),
+        _prefix(prefix), _numNames(0) {}
+    virtual ~DerivedVisitor() {}
+
+    // Get the derived grids or params created.
+    const vector<shared_ptr<Grid>>& getDerived() const {
+        return _derived;
+    }
+};
+
+// A visitor that replaces sub-exprs that read only time-invariant grids
+// and params w/reads of derived grids, whose values are computed once
+// before the time steps.
+// Example: delta_t / (h * (rho(x,y,z) + rho(x,y-1,z))) => derived_1(x,y,z)
+// w/derived_1 defined by that expr.
+// A sub-expr is hoisted only if it reads more than one grid point or
+// divides, so a single read replaces more work. Grids w/interior values
+// are not hoisted so that InteriorVisitor can still replace them.
+// Must be applied before equations are found.
+class HoistVisitor : public DerivedVisitor {
+protected:
+    IntTuple _ofs;              // spatial offsets of current LHS point.
 
-                    // Put ce2's operands into ce.
-                    ce->mergeExpr(ce2);
+    // Params are invariant but not counted as reads.
+    virtual bool isInvariantPoint(const GridPointPtr& gpp, int& numReads) const {
+        if (gpp->isParam())
+            return true;
+        const Grid* gp = gpp->getGrid();
+        if (gp->lookup("t") || gp->getExprs().size() ||
+            gp->hasInteriorValue() || gp->isDerived())
+            return false;
+        numReads++;
+        return true;
+    }
 
-                    // Bail out of for loop because we have modified ops.
-                    _numChanges++;
-                    done = false;
-                    break;
+    // Whether an invariant expr is worth a derived grid.
+    static bool isWorthHoisting(int numReads, bool hasDiv) {
+        return numReads > 1 || (numReads == 1 && hasDiv);
+    }
+
+    // Return a read at the current LHS point of a derived grid
+    // w/values defined by 'ep'.
+    virtual ExprPtr makeRead(const ExprPtr& ep) {
+
+        // Make the defining expr relative to the LHS point.
+        ExprPtr dep = ep->clone();
+        ShiftVisitor sv(_ofs);
+        dep->accept(&sv);
+
+        IntTuple dims;
+        for (auto dim : _ofs.getDims())
+            dims.addDim(dim, 0);
+        Grid* dgp = getDerived(dims, false, dep);
+        _numChanges++;
+        return make_shared<GridPoint>(dgp, _ofs);
+    }
+
+    // Replace the largest worthwhile invariant sub-exprs of 'ep'.
+    virtual void hoist(ExprPtr& ep) {
+        int numReads = 0;
+        bool hasDiv = false;
+        if (isInvariant(ep, numReads, hasDiv)) {
+            if (isWorthHoisting(numReads, hasDiv))
+                ep = makeRead(ep);
+            return;
+        }
+
+        // In a commutative expr, the invariant operands are grouped
+        // into one derived grid, e.g., '2 * mu * d' => 'derived_1 * d'.
+        auto ce = dynamic_pointer_cast<CommutativeExpr>(ep);
+        if (ce) {
+            auto& ops = ce->getOps();
+            auto ice = make_shared<CommutativeExpr>(ce->getOpStr());
+            int first = -1;
+            numReads = 0;
+            hasDiv = false;
+            for (size_t i = 0; i < ops.size(); i++) {
+                int n = 0;
+                bool d = false;
+                if (isInvariant(ops[i], n, d)) {
+                    numReads += n;
+                    hasDiv = hasDiv || d;
+                    ice->getOps().push_back(ops[i]);
+                    if (first < 0)
+                        first = int(i);
                 }
+                else
+                    hoist(ops[i]);
+            }
+            if (first < 0 || !isWorthHoisting(numReads, hasDiv))
+                return;
+
+            // Put the derived read in place of the first invariant op.
+            ExprPtrVec nops;
+            for (size_t i = 0; i < ops.size(); i++) {
+                if (int(i) == first)
+                    nops.push_back(makeRead(ice->getOps().size() == 1 ?
+                                            ice->getOps()[0] : ice));
+                else if (find(ice->getOps().begin(), ice->getOps().end(),
+                              ops[i]) == ice->getOps().end())
+                    nops.push_back(ops[i]);
             }
+            ops.swap(nops);
+            return;
         }
+        auto be = dynamic_pointer_cast<BinaryExpr>(ep);
+        if (be) {
+            hoist(be->getLhs());
+            hoist(be->getRhs());
+            return;
+        }
+        auto ue = dynamic_pointer_cast<UnaryExpr>(ep);
+        if (ue)
+            hoist(ue->getRhs());
+    }
+
+public:
+    HoistVisitor(const Grids& grids, const Params& params) :
+        DerivedVisitor("invariant hoisting", "derived_", grids, params) {}
+    virtual ~HoistVisitor() {}
+
+    // Only the RHS is changed. Derived grids have the spatial dims of
+    // the LHS, so equations for grids w/o all of x, y, and z or w/other
+    // non-time dims are skipped.
+    virtual void visit(EqualsExpr* ee) {
+        auto lhs = ee->getLhs();
+        _ofs = IntTuple();
+        for (auto dim : lhs->getDims()) {
+            if (dim == "t")
+                continue;
+            if (dim != "x" && dim != "y" && dim != "z")
+                return;
+            _ofs.addDim(dim, lhs->getVal(dim));
+        }
+        if (_ofs.size() == 3)
+            hoist(ee->getRhs());
     }
-    
 };
 
+// A visitor that replaces divisions by constants and params w/
+// multiplications by reciprocals.
+// Example: a / 4 => a * 0.25 and a / h => a * derived_param_1 w/
+// derived_param_1 defined by 1 / h.
+// Sub-exprs that read only params and divide, e.g., 'delta_t / h', are
+// replaced by derived params as a whole. Derived params are computed
+// once before the time steps, so no divisions by them remain in the
+// stencil code. Divisions by grid values are not changed.
+// Must be applied before equations are found.
+class RecipVisitor : public DerivedVisitor {
+protected:
+
+    // Only params are invariant; they are counted as reads.
+    virtual bool isInvariantPoint(const GridPointPtr& gpp, int& numReads) const {
+        if (!gpp->isParam())
+            return false;
+        numReads++;
+        return true;
+    }
+
+    // Return a read of a derived param w/the value of 'ep'.
+    virtual ExprPtr makeRead(const ExprPtr& ep) {
+        Grid* dpp = getDerived(IntTuple(), true, ep->clone());
+        _numChanges++;
+        return make_shared<GridPoint>(dpp, *dpp);
+    }
+
+    // Remove the divisions from 'ep' where possible.
+    virtual void elim(ExprPtr& ep) {
+        int numParams = 0;
+        bool hasDiv = false;
+        if (isInvariant(ep, numParams, hasDiv)) {
+            if (numParams && hasDiv)
+                ep = makeRead(ep);
+            return;
+        }
+        auto de = dynamic_pointer_cast<DivExpr>(ep);
+        if (de) {
+            elim(de->getLhs());
+            auto& rhs = de->getRhs();
+
+            // Division by a constant.
+            auto cp = dynamic_pointer_cast<ConstExpr>(rhs);
+            if (cp && cp->getVal() != 0.0) {
+                ep = make_shared<MultExpr>(de->getLhs(),
+                                           constGridValue(1.0 / cp->getVal()));
+                _numChanges++;
+                return;
+            }
+
+            // Division by params.
+            numParams = 0;
+            if (isInvariant(rhs, numParams, hasDiv) && numParams) {
+                ep = make_shared<MultExpr>(de->getLhs(),
+                                           makeRead(constGridValue(1.0) / rhs));
+                return;
+            }
+            elim(rhs);
+            return;
+        }
+        auto be = dynamic_pointer_cast<BinaryExpr>(ep);
+        if (be) {
+            elim(be->getLhs());
+            elim(be->getRhs());
+            return;
+        }
+        auto ue = dynamic_pointer_cast<UnaryExpr>(ep);
+        if (ue) {
+            elim(ue->getRhs());
+            return;
+        }
+        auto ce = dynamic_pointer_cast<CommutativeExpr>(ep);
+        if (ce) {
+            for (auto& op : ce->getOps())
+                elim(op);
+        }
+    }
+
+public:
+    RecipVisitor(const Grids& grids, const Params& params) :
+        DerivedVisitor("division elimination", "derived_param_", grids, params) {}
+    virtual ~RecipVisitor() {}
+
+    // Only the RHS is changed.
+    virtual void visit(EqualsExpr* ee) {
+        elim(ee->getRhs());
+    }
+};
 
 // A visitor that eliminates common subexprs.
-// TODO: find matches to subsets of commutative operations;
-// example: a+b+c * b+d+a => c+(a+b) * d+(a+b) w/expr a+b combined.
+// Nodes are interned by structural hash, so each node is compared only
+// to the seen nodes with the same hash, and matches are shared.
+// Matches to subsets of products are found by PairVisitor.
 class CseVisitor : public OptVisitor {
 protected:
     set<ExprPtr> _seen;
+    ExprHashes _hashes;       // cached hash of each node.
+    unordered_map<size_t, ExprPtrVec> _interned; // seen nodes by hash.
     
     // If 'ep' has already been seen, just return true.
     // Else if 'ep' has a match, change pointer to that match, return true.
@@ -130,8 +596,11 @@ protected:
             return true;
         }
         
-        // Loop through nodes already seen.
-        for (auto oep : _seen) {
+        // Loop through nodes already seen w/the same hash.
+        // Redirecting a pointer to a match doesn't change the
+        // structure, so cached hashes remain valid.
+        auto& candidates = _interned[ep->getHash(_hashes)];
+        for (auto oep : candidates) {
 #ifdef DEBUG_MATCHING
             cerr << " - comparing " << ep->makeStr() << " to " << oep->makeStr() << endl;
 #endif
@@ -154,6 +623,7 @@ protected:
         cerr << " - no match to " << ep->makeStr() << endl;
 #endif
         _seen.insert(ep);
+        candidates.push_back(ep);
         return false;
     }
     
@@ -195,6 +665,148 @@ public:
     }
 };
 
+// A visitor that shares pairs of factors that appear together in more
+// than one product, e.g., in the exprs for different grids updated by
+// the same equation.
+// Example: a*b*c and a*b*d => (a*b)*c and (a*b)*d w/expr a*b shared.
+// Sums are not re-associated, so they keep the same evaluation order
+// as the scalar reference code.
+// Operands must already be shared by CSE, and CSE should be applied
+// again afterward to combine any new exprs w/existing ones.
+class PairVisitor : public OptVisitor {
+protected:
+    typedef pair<Expr*, Expr*> ExprPair;
+    typedef pair<string, ExprPair> PairKey;
+
+    set<Expr*> _done;           // nodes already visited.
+    map<PairKey, CommutativeExpr*> _nodes; // last expr seen w/each pair.
+    map<PairKey, ExprPtr> _pairs; // shared expr for each pair.
+
+    // Make key for operands 'a' and 'b' of an expr w/operator 'opStr'.
+    static PairKey makeKey(const string& opStr, Expr* a, Expr* b) {
+        return PairKey(opStr, a < b ? ExprPair(a, b) : ExprPair(b, a));
+    }
+
+    // Return index of 'ep' in 'ops' other than 'skip', or -1 if none.
+    static int findOp(const ExprPtrVec& ops, Expr* ep, int skip = -1) {
+        for (size_t i = 0; i < ops.size(); i++)
+            if (ops[i].get() == ep && int(i) != skip)
+                return int(i);
+        return -1;
+    }
+
+    // Replace operands 'a' and 'b' of 'ce' with 'pe'.
+    // Return false if 'ce' doesn't have both or has no others.
+    virtual bool replacePair(CommutativeExpr* ce, Expr* a, Expr* b, ExprPtr pe) {
+        auto& ops = ce->getOps();
+        if (ops.size() <= 2)
+            return false;
+        int i = findOp(ops, a);
+        int j = findOp(ops, b, i);
+        if (i < 0 || j < 0)
+            return false;
+        ops[min(i, j)] = pe;
+        ops.erase(ops.begin() + max(i, j));
+        _numChanges++;
+        return true;
+    }
+
+    // Remember each pair of operands in 'ce'.
+    virtual void addPairs(CommutativeExpr* ce) {
+        auto& opStr = ce->getOpStr();
+        auto& ops = ce->getOps();
+        for (size_t i = 0; i < ops.size(); i++)
+            for (size_t j = i + 1; j < ops.size(); j++)
+                _nodes[makeKey(opStr, ops[i].get(), ops[j].get())] = ce;
+    }
+
+    // Remember each pair of operands in 'ce' that includes 'ep'.
+    virtual void addPairs(CommutativeExpr* ce, Expr* ep) {
+        auto& opStr = ce->getOpStr();
+        for (auto op : ce->getOps()) {
+            if (op.get() != ep)
+                _nodes[makeKey(opStr, ep, op.get())] = ce;
+        }
+    }
+
+    // Try to share operands 'i' and 'j' of 'ce' w/another expr.
+    // Return true if they were replaced w/a shared pair.
+    virtual bool sharePair(CommutativeExpr* ce, size_t i, size_t j) {
+        auto& opStr = ce->getOpStr();
+        auto& ops = ce->getOps();
+        Expr* a = ops[i].get();
+        Expr* b = ops[j].get();
+        auto key = makeKey(opStr, a, b);
+
+        // Pair already shared?
+        auto pi = _pairs.find(key);
+        if (pi != _pairs.end())
+            return replacePair(ce, a, b, pi->second);
+
+        // Pair still in another expr?
+        auto ni = _nodes.find(key);
+        if (ni == _nodes.end() || ni->second == ce)
+            return false;
+        auto* oce = ni->second;
+        int oi = findOp(oce->getOps(), a);
+        if (oi < 0 || findOp(oce->getOps(), b, oi) < 0)
+            return false;
+
+        // Make a new expr for the pair and use it in both.
+        auto pe = make_shared<MultExpr>();
+        pe->getOps().push_back(ops[i]);
+        pe->getOps().push_back(ops[j]);
+        _pairs[key] = pe;
+        if (replacePair(oce, a, b, pe))
+            addPairs(oce, pe.get());
+        return replacePair(ce, a, b, pe);
+    }
+
+public:
+    PairVisitor() :
+        OptVisitor("operand-pair sharing") {}
+    virtual ~PairVisitor() {}
+
+    // Visit shared nodes only once.
+    virtual void visit(UnaryExpr* ue) {
+        if (_done.count(ue))
+            return;
+        _done.insert(ue);
+        ue->getRhs()->accept(this);
+    }
+    virtual void visit(BinaryExpr* be) {
+        if (_done.count(be))
+            return;
+        _done.insert(be);
+        be->getLhs()->accept(this);
+        be->getRhs()->accept(this);
+    }
+    virtual void visit(CommutativeExpr* ce) {
+        if (_done.count(ce))
+            return;
+        _done.insert(ce);
+
+        // Visit ops first (depth-first).
+        for (auto ep : ce->getOps())
+            ep->accept(this);
+        if (ce->getOpStr() != MultExpr::opStr())
+            return;
+
+        // Share pairs greedily. A shared pair replaces operand 'i',
+        // so it is tried again w/the remaining operands.
+        auto& ops = ce->getOps();
+        for (size_t i = 0; i < ops.size(); i++) {
+            for (size_t j = i + 1; j < ops.size(); ) {
+                if (sharePair(ce, i, j))
+                    j = i + 1;
+                else
+                    j++;
+            }
+        }
+        addPairs(ce);
+    }
+};
+
 // A visitor that can keep track of what's been visted.
 class TrackingVisitor : public ExprVisitor {
 protected:
@@ -231,9 +843,11 @@ protected:
     int _numOps, _numNodes, _numReads, _numWrites, _numParamReads;
 
     // Vars to track min and max points seen for every grid.
-    // TODO: track all points to enable queries for halo, temporal
-    // extent, and required exchanges.
     map<const Grid*, IntTuple> _maxPoints, _minPoints;
+
+    // All points seen for every grid.
+    // TODO: use these for queries for halo and required exchanges.
+    map<const Grid*, set<IntTuple>> _allPoints;
     const IntTuple* getPoints(const Grid* gp,
                               const map<const Grid*, IntTuple>& mp) const {
         auto i = mp.find(gp);
@@ -272,6 +886,12 @@ public:
     const IntTuple* getMinPoints(const Grid* gp) const {
         return getPoints(gp, _minPoints);
     }
+    const set<IntTuple>* getAllPoints(const Grid* gp) const {
+        auto i = _allPoints.find(gp);
+        if (i != _allPoints.end())
+            return &(i->second);
+        return 0;
+    }
 
     // Return halo needed for given grid in given dimension.
     // TODO: allow separate halos for beginning and end.
@@ -312,6 +932,7 @@ public:
         maxp = gp->maxElements(maxp, false);
         auto& minp = _minPoints[g];
         minp = gp->minElements(minp, false);
+        _allPoints[g].insert(*gp);
     }
     
     // Unary: Count as one op and visit operand.
@@ -56,8 +56,47 @@ void PrintVisitorTopDown::visit(UnaryExpr* ue) {
     _numCommon += _ph.getNumCommon(ue);
 }
 
+// Return expr for 'ep' without adding it to _exprStr.
+string PrintVisitorTopDown::getOperandStr(ExprPtr& ep) {
+    string prev = getExprStrAndClear();
+    ep->accept(this);
+    string opStr = getExprStrAndClear();
+    _exprStr = prev;
+    return opStr;
+}
+
+// Set 'a' to all but the last factor of 'prod' and 'b' to the last one.
+void PrintVisitorTopDown::getFmaOps(CommutativeExpr* prod, string& a, string& b) {
+    ExprPtrVec& ops = prod->getOps();
+    a = b = "";
+    for (size_t i = 0; i < ops.size() - 1; i++) {
+        if (i > 0)
+            a += " * ";
+        a += getOperandStr(ops[i]);
+    }
+    if (ops.size() > 2)
+        a = "(" + a + ")";
+    b = getOperandStr(ops.back());
+    _numCommon += _ph.getNumCommon(prod);
+}
+
 // A generic binary operator.
 void PrintVisitorTopDown::visit(BinaryExpr* be) {
+
+    // Fuse a product on either side of a subtraction.
+    if (be->getOpStr() == SubExpr::opStr()) {
+        CommutativeExpr* lp = getFusableProduct(be->getLhs());
+        CommutativeExpr* rp = lp ? NULL : getFusableProduct(be->getRhs());
+        if (lp || rp) {
+            string a, b;
+            getFmaOps(lp ? lp : rp, a, b);
+            string c = getOperandStr(lp ? be->getRhs() : be->getLhs());
+            _exprStr += _ph.makeFma(a, b, c, rp != NULL, lp != NULL);
+            _numCommon += _ph.getNumCommon(be);
+            return;
+        }
+    }
+
     _exprStr += "(";
     be->getLhs()->accept(this); // adds LHS to _exprStr.
     _exprStr += " " + be->getOpStr() + " ";
@@ -68,8 +107,42 @@ void PrintVisitorTopDown::visit(BinaryExpr* be) {
 
 // A commutative operator.
 void PrintVisitorTopDown::visit(CommutativeExpr* ce) {
-    _exprStr += "(";
     ExprPtrVec& ops = ce->getOps();
+
+    // Fuse products into a sum, starting with another term if there is one.
+    // Example: 'a + b*c + d*e' becomes 'fma(d, e, fma(b, c, a))'.
+    if (ce->getOpStr() == AddExpr::opStr()) {
+        size_t first = ops.size();
+        int numProds = 0;
+        for (size_t i = 0; i < ops.size(); i++) {
+            if (getFusableProduct(ops[i]))
+                numProds++;
+            else if (first == ops.size())
+                first = i;
+        }
+        if (numProds) {
+            if (first == ops.size())
+                first = 0;
+            string sum = getOperandStr(ops[first]);
+            for (size_t i = 0; i < ops.size(); i++) {
+                if (i == first)
+                    continue;
+                CommutativeExpr* prod = getFusableProduct(ops[i]);
+                if (prod) {
+                    string a, b;
+                    getFmaOps(prod, a, b);
+                    sum = _ph.makeFma(a, b, sum);
+                }
+                else
+                    sum = "(" + sum + " + " + getOperandStr(ops[i]) + ")";
+            }
+            _exprStr += sum;
+            _numCommon += _ph.getNumCommon(ce);
+            return;
+        }
+    }
+    
+    _exprStr += "(";
     int opNum = 0;
     for (auto ep : ops) {
         if (opNum > 0)
@@ -112,6 +185,28 @@ ostream& PrintVisitorBottomUp::makeNextTempVar(Expr* ex, string comment) {
     return _os;
 }
 
+// Set 'a' to all but the last factor of 'prod' and 'b' to the last one.
+void PrintVisitorBottomUp::getFmaOps(CommutativeExpr* prod, string& a, string& b) {
+    ExprPtrVec& ops = prod->getOps();
+    string exStr;
+    for (size_t i = 0; i < ops.size() - 1; i++) {
+        ops[i]->accept(this); // sets _exprStr.
+        string opStr = getExprStrAndClear();
+        if (i == 0) {
+            a = opStr;
+            exStr = ops[i]->makeStr();
+        }
+        else {
+            exStr += ' ' + prod->getOpStr() + ' ' + ops[i]->makeStr();
+            makeNextTempVar(NULL, exStr) << a << ' ' << prod->getOpStr() << ' ' <<
+                opStr << _ph.getLineSuffix();
+            a = getExprStrAndClear();
+        }
+    }
+    ops.back()->accept(this); // sets _exprStr.
+    b = getExprStrAndClear();
+}
+
 // Look for existing var.
 // Then, use top-down method for simple exprs.
 // Return true if successful.
@@ -199,6 +294,23 @@ void PrintVisitorBottomUp::visit(BinaryExpr* be) {
     if (tryTopDown(be, false))
         return;
 
+    // Fuse a product on either side of a subtraction.
+    // Example: 'a - b*c' might output the following:
+    // temp1 = fnma(b, c, a);
+    if (be->getOpStr() == SubExpr::opStr()) {
+        CommutativeExpr* lp = getFusableProduct(be->getLhs());
+        CommutativeExpr* rp = lp ? NULL : getFusableProduct(be->getRhs());
+        if (lp || rp) {
+            string a, b;
+            getFmaOps(lp ? lp : rp, a, b);
+            (lp ? be->getRhs() : be->getLhs())->accept(this); // sets _exprStr.
+            string c = getExprStrAndClear();
+            makeNextTempVar(be) << _ph.makeFma(a, b, c, rp != NULL, lp != NULL) <<
+                _ph.getLineSuffix();
+            return;
+        }
+    }
+
     // Expand both sides, then apply operator to result.
     // Example: '(a * b) / (c * d)' might output the following:
     // temp1 = a * b;
@@ -220,6 +332,58 @@ void PrintVisitorBottomUp::visit(CommutativeExpr* ce) {
     // and 'a*b' is saved in _exprStr.
     if (tryTopDown(ce, false))
         return;
+    ExprPtrVec& ops = ce->getOps();
+    assert(ops.size() > 1);
+
+    // Fuse products into a sum, starting with another term if there is one.
+    // Example: 'a + b*c + d*e' might output the following:
+    // temp1 = fma(b, c, a);
+    // temp2 = fma(d, e, temp1);
+    // with 'temp2' left in _exprStr;
+    if (ce->getOpStr() == AddExpr::opStr()) {
+        size_t first = ops.size();
+        int numProds = 0;
+        for (size_t i = 0; i < ops.size(); i++) {
+            if (getFusableProduct(ops[i]))
+                numProds++;
+            else if (first == ops.size())
+                first = i;
+        }
+        if (numProds) {
+            if (first == ops.size())
+                first = 0;
+            ops[first]->accept(this); // sets _exprStr.
+            string sum = getExprStrAndClear();
+            string exStr = ops[first]->makeStr();
+            size_t opNum = 1;
+            for (size_t i = 0; i < ops.size(); i++) {
+                if (i == first)
+                    continue;
+                auto& ep = ops[i];
+                opNum++;
+
+                // Use whole expression only for the last step.
+                Expr* ex = (opNum == ops.size()) ? ce : NULL;
+                exStr += ' ' + ce->getOpStr() + ' ' + ep->makeStr();
+
+                CommutativeExpr* prod = getFusableProduct(ep);
+                if (prod) {
+                    string a, b;
+                    getFmaOps(prod, a, b);
+                    makeNextTempVar(ex, exStr) << _ph.makeFma(a, b, sum) <<
+                        _ph.getLineSuffix();
+                }
+                else {
+                    ep->accept(this); // sets _exprStr.
+                    string opStr = getExprStrAndClear();
+                    makeNextTempVar(ex, exStr) << sum << ' ' << ce->getOpStr() << ' ' <<
+                        opStr << _ph.getLineSuffix();
+                }
+                sum = getExprStr(); // result used in next iteration, if any.
+            }
+            return;
+        }
+    }
 
     // Make separate assignment for N-1 operands.
     // Example: 'a + b + c + d' might output the following:
@@ -227,8 +391,6 @@ void PrintVisitorBottomUp::visit(CommutativeExpr* ce) {
     // temp2 = temp1 + c;
     // temp3 = temp2 = d;
     // with 'temp3' left in _exprStr;
-    ExprPtrVec& ops = ce->getOps();
-    assert(ops.size() > 1);
     string lhs, exStr;
     int opNum = 0;
     for (auto ep : ops) {
@@ -359,13 +521,34 @@ void YASKCppPrinter::printCode(ostream& os) {
     // Create the overall context class.
     {
         // get stats for just one element (not cluster).
+        // Include derived grids' exprs so that halos cover their reads.
         CounterVisitor cve;
         _grids.acceptToFirst(&cve);
-        IntTuple maxHalos;
-
+        for (auto gp : _grids)
+            if (gp->isDerived())
+                gp->getDerivedExpr()->accept(&cve);
+        IntTuple maxHalos, interiorHalos;
+        interiorHalos.addDim("x", 0);
+        interiorHalos.addDim("y", 0);
+        interiorHalos.addDim("z", 0);
+
+        // The context is templated on the grid layouts so that kernels
+        // for more than one layout can be instantiated and selected at
+        // run-time.
         os << endl << " ////// Overall stencil-context class //////" << endl <<
+            "template <typename Layout3d = LAYOUT_3D, typename Layout4d = LAYOUT_4D>" << endl <<
             "struct " << _context << " : public StencilContext {" << endl;
 
+        // Grid types.
+        os << endl << " // Grid types." << endl <<
+            " typedef RealVecGrid_XYZ<Layout3d> Grid_XYZ;" << endl <<
+            " typedef RealVecGrid_NXYZ<Layout4d> Grid_NXYZ;" << endl <<
+            " template <idx_t TimeSlots> using Grid_TXYZ = RealVecGrid_TXYZ<Layout4d, TimeSlots>;" << endl <<
+            " template <idx_t TimeSlots> using Grid_TNXYZ = RealVecGrid_TNXYZ<Layout4d, TimeSlots>;" << endl <<
+            " typedef RealVecGrid_X Grid_X;" << endl <<
+            " typedef RealVecGrid_Y Grid_Y;" << endl <<
+            " typedef RealVecGrid_Z Grid_Z;" << endl;
+
         // Grids.
         os << endl << " // Grids." << endl;
         map<Grid*, string> typeNames, dimArgs, padArgs;
@@ -384,7 +567,13 @@ void YASKCppPrinter::printCode(ostream& os) {
                 // don't want the time dimension during construction.
                 // TODO: make this more generic.
                 if (dim != "t") {
-                    dimArg += "d" + dim + ", ";
+
+                    // Allocate whole clusters in x, y, and z; the domain
+                    // may end in a partial cluster.
+                    if (dim == "n")
+                        dimArg += "d" + dim + ", ";
+                    else
+                        dimArg += "ROUND_UP(d" + dim + ", CPTS_" + ucDim + "), ";
 
                     // Halo for this dimension.
                     int halo = cve.getHalo(gp, dim);
@@ -397,18 +586,26 @@ void YASKCppPrinter::printCode(ostream& os) {
                         *mh = max(*mh, halo);
                     else
                         maxHalos.addDim(dim, halo);
+                    if (gp->hasInteriorValue())
+                        interiorHalos.setVal(dim, max(interiorHalos.getVal(dim), halo));
 
                     // Total padding = halo + extra.
                     padArg += hvar + " + p" + dim + ", ";
                 }
             }
+            if (gp->lookup("t"))
+                typeName += "<TIME_SLOTS(" + to_string(gp->getTimeSlots()) + ")>";
             typeNames[gp] = typeName;
             dimArgs[gp] = dimArg;
             padArgs[gp] = padArg;
             os << " " << typeName << "* " << grid << "; // ";
-            if (_equations.getEqGrids().count(gp) == 0)
-                os << "not ";
-            os << "updated by stencil." << endl;
+            if (gp->isDerived())
+                os << "derived during init." << endl;
+            else {
+                if (_equations.getEqGrids().count(gp) == 0)
+                    os << "not ";
+                os << "updated by stencil." << endl;
+            }
         }
 
         // Max halos.
@@ -416,6 +613,10 @@ void YASKCppPrinter::printCode(ostream& os) {
         for (auto dim : maxHalos.getDims())
             os << " const idx_t max_halo_" << dim << " = " <<
                 maxHalos.getVal(dim) << ";" << endl;
+        os << endl << " // Max halos across grids with interior values." << endl;
+        for (auto dim : interiorHalos.getDims())
+            os << " const idx_t interior_halo_" << dim << " = " <<
+                interiorHalos.getVal(dim) << ";" << endl;
 
         // Parameters.
         map<Param*, string> paramTypeNames, paramDimArgs;
@@ -441,7 +642,10 @@ void YASKCppPrinter::printCode(ostream& os) {
             
             paramTypeNames[pp] = typeName;
             paramDimArgs[pp] = dimArg;
-            os << " " << typeName << "* " << param << ";" << endl;
+            os << " " << typeName << "* " << param << ";";
+            if (pp->isDerived())
+                os << " // derived during init.";
+            os << endl;
         }
 
         // Ctor.
@@ -490,6 +694,113 @@ void YASKCppPrinter::printCode(ostream& os) {
         }
         os << " }" << endl;
 
+        // Set and check interior values.
+        // The interior kernels assume these values, so real data is only
+        // checked; values are set only in test data.
+        bool hasInteriorVals = false;
+        for (auto gp : _grids)
+            if (gp->hasInteriorValue())
+                hasInteriorVals = true;
+        if (hasInteriorVals) {
+            for (int check = 0; check < 2; check++) {
+                if (check)
+                    os << endl << " virtual idx_t checkInterior() {" << endl <<
+                        "  idx_t errs = 0;" << endl;
+                else
+                    os << endl << " virtual void initInterior() {" << endl;
+                for (auto gp : _grids) {
+                    if (!gp->hasInteriorValue())
+                        continue;
+                    string grid = gp->getName();
+                    string val = CppPrintHelper::formatReal(gp->getInteriorValue());
+
+                    // Interior may extend into the halo, but not past this grid's.
+                    string indent = "  ", args, fmt;
+                    for (auto dim : gp->getDims()) {
+                        if (dim != "x" && dim != "y" && dim != "z") {
+                            cerr << "Error: interior value set for grid '" << grid <<
+                                "', which has non-spatial dimension '" << dim << "'." << endl;
+                            exit(1);
+                        }
+                        string hvar = grid + "_halo_" + dim;
+                        os << indent << "for (idx_t " << dim << " = std::max(begin_i" << dim <<
+                            ", -" << hvar << "); " << dim << " < std::min(end_i" << dim <<
+                            ", d" << dim << " + " << hvar << "); " << dim << "++)" << endl;
+                        indent += " ";
+                        if (fmt.length())
+                            fmt += " << \", \" << ";
+                        fmt += dim;
+                        args += dim + ", ";
+                    }
+                    if (check)
+                        os << indent << "{" << endl <<
+                            indent << " real_t v = " << grid << "->readElem(" << args <<
+                            "__LINE__);" << endl <<
+                            indent << " if (v != " << val << " && errs++ == 0)" << endl <<
+                            indent << "  std::cerr << \"Error: grid '" << grid <<
+                            "' is \" << v << \" at (\" << " << fmt <<
+                            " << \") in the interior, where it must be " <<
+                            gp->getInteriorValue() << ".\" << std::endl;" << endl <<
+                            indent << "}" << endl;
+                    else
+                        os << indent << grid << "->writeElem(" << val <<
+                            ", " << args << "__LINE__);" << endl;
+                }
+                if (check)
+                    os << "  return errs;" << endl;
+                os << " }" << endl;
+            }
+        }
+
+        // Compute derived params and grids.
+        bool hasDerivedParams = false, hasDerivedGrids = false;
+        for (auto pp : _params)
+            if (pp->isDerived())
+                hasDerivedParams = true;
+        for (auto gp : _grids)
+            if (gp->isDerived())
+                hasDerivedGrids = true;
+        if (hasDerivedParams || hasDerivedGrids) {
+            os << endl << " virtual void initDerived() {" << endl <<
+                "  auto& context = *this;" << endl;
+
+            // Params first; derived grids don't read them.
+            if (hasDerivedParams) {
+                CounterVisitor cv;
+                for (auto pp : _params)
+                    if (pp->isDerived())
+                        pp->getDerivedExpr()->accept(&cv);
+                CppPrintHelper sp(&cv, "param_temp", "real_t", "  ", ";\n");
+                PrintVisitorBottomUp pcv(os, sp, _exprSize);
+                for (auto pp : _params)
+                    if (pp->isDerived())
+                        pp->getDerivedExpr()->accept(&pcv);
+            }
+
+            // Whole clusters are computed, like the stencil equations.
+            if (hasDerivedGrids) {
+                string indent = "  ";
+                for (string dim : { "x", "y", "z" }) {
+                    os << indent << "for (idx_t " << dim << " = 0; " << dim <<
+                        " < ROUND_UP(d" << dim << ", CPTS_" << allCaps(dim) << "); " <<
+                        dim << "++)" << endl;
+                    indent += " ";
+                }
+                os << indent << "{" << endl;
+                CounterVisitor cv;
+                for (auto gp : _grids)
+                    if (gp->isDerived())
+                        gp->getDerivedExpr()->accept(&cv);
+                CppPrintHelper sp(&cv, "temp", "real_t", indent + " ", ";\n");
+                PrintVisitorBottomUp pcv(os, sp, _exprSize);
+                for (auto gp : _grids)
+                    if (gp->isDerived())
+                        gp->getDerivedExpr()->accept(&pcv);
+                os << indent << "}" << endl;
+            }
+            os << " }" << endl;
+        }
+
         // end of context.
         os << "};" << endl;
     }
@@ -512,12 +823,20 @@ void YASKCppPrinter::printCode(ostream& os) {
         addComment(os, eq.grids);
         os << " const int scalar_fp_ops = " << fpops.getNumOps() << ";" << endl;
 
+        // Wavefront angles.
+        os << endl << " // Spatial shift before evaluating this equation in a temporal wavefront." << endl;
+        for (string dim : { "n", "x", "y", "z" }) {
+            const int* ap = eq.angles.lookup(dim);
+            os << " const idx_t angle_" << dim << " = " << (ap ? *ap : 0) << ";" << endl;
+        }
+
         // Init code.
         {
             os << endl << " // All grids updated by this equation." << endl <<
                 " std::vector<RealVecGridBase*> eqGridPtrs;" << endl;
 
-            os << " void init(" << _context << "& context) {" << endl;
+            os << " template <typename ContextClass>" << endl <<
+                " void init(ContextClass& context) {" << endl;
 
             // Grids w/equations.
             os << "  eqGridPtrs.clear();" << endl;
@@ -526,28 +845,66 @@ void YASKCppPrinter::printCode(ostream& os) {
             }
             os << " }" << endl;
         }
+
+        // Sub-domain bounds.
+        {
+            os << endl << " // Get bounds of the sub-domain in rank-local indices:" << endl <<
+                " // " << eq.subDomain.makeStr() << "." << endl <<
+                " // Bounds are not clipped to the rank domain." << endl <<
+                " template <typename ContextClass>" << endl <<
+                " void get_bounds(ContextClass& context," << endl <<
+                "                 idx_t& begin_x, idx_t& begin_y, idx_t& begin_z," << endl <<
+                "                 idx_t& end_x, idx_t& end_y, idx_t& end_z) {" << endl;
+            auto& bounds = eq.subDomain.getBounds();
+            for (auto& bi : bounds)
+                if (bi.first != "x" && bi.first != "y" && bi.first != "z") {
+                    cerr << "Error: sub-domain of equation '" << eq.name <<
+                        "' restricts non-spatial dimension '" << bi.first << "'." << endl;
+                    exit(1);
+                }
+            for (string dim : { "x", "y", "z" }) {
+                auto bi = bounds.find(dim);
+                if (bi == bounds.end())
+                    os << "  begin_" << dim << " = 0;" << endl <<
+                        "  end_" << dim << " = context.d" << dim << ";" << endl;
+                else {
+                    int n = 0;
+                    for (auto& b : { bi->second.first, bi->second.second }) {
+                        os << "  " << (n++ ? "end_" : "begin_") << dim << " = ";
+                        if (b.fromEnd)
+                            os << "context.nr" << dim << " * context.d" << dim << " - " << b.ofs;
+                        else
+                            os << b.ofs;
+                        os << " - context.ofs_" << dim << ";" << endl;
+                    }
+                }
+            }
+            os << " }" << endl;
+        }
             
         // Scalar code.
         {
             // C++ scalar print assistant.
             CounterVisitor cv;
-            eq.grids.acceptToFirst(&cv);
+            eq.grids.acceptToRef(&cv);
             CppPrintHelper* sp = new CppPrintHelper(&cv, "temp", "real_t", " ", ";\n");
             
             // Stencil-calculation code.
             // Function header.
             os << endl << " // Calculate one scalar result relative to indices " <<
                 _dimCounts.makeDimStr(", ") << "." << endl;
-            os << " void calc_scalar(" << _context << "& context, " <<
+            os << " template <typename ContextClass>" << endl <<
+                " void calc_scalar(ContextClass& context, " <<
                 _dimCounts.makeDimStr(", ", "idx_t ") << ") {" << endl;
 
             // C++ code generator.
             // The visitor is accepted at all nodes in the AST;
             // for each node in the AST, code is generated and
             // stored in the expression-string in the visitor.
-            // Visit only first expression in each, since we don't want clustering.
+            // Visit only reference expression in each, since we don't want
+            // clustering or derived grids.
             PrintVisitorBottomUp pcv(os, *sp, _exprSize);
-            eq.grids.acceptToFirst(&pcv);
+            eq.grids.acceptToRef(&pcv);
 
             // End of function.
             os << "} // scalar calculation." << endl;
@@ -562,6 +919,15 @@ void YASKCppPrinter::printCode(ostream& os) {
         // for each grid access node in the AST, the vectors
         // needed are determined and saved in the visitor.
         {
+            // Replace sums of unaligned points with partial sums if requested.
+            // Sums may be shared w/other equations, so they are copied first.
+            PartialSumVisitor psv(_foldLengths);
+            if (_equations.getSemiStencil()) {
+                CopyVisitor cpv;
+                eq.grids.acceptToAll(&cpv);
+                eq.grids.acceptToAll(&psv);
+            }
+
             // Create vector info for this equation.
             VecInfoVisitor vv(_foldLengths);
             eq.grids.acceptToAll(&vv);
@@ -573,9 +939,12 @@ void YASKCppPrinter::printCode(ostream& os) {
 #endif
             
             // C++ vector print assistant.
+            // Count over all cluster points and grids so that sub-exprs
+            // shared between them are evaluated once per cluster.
             CounterVisitor cv;
-            eq.grids.acceptToFirst(&cv);
+            eq.grids.acceptToAll(&cv);
             CppVecPrintHelper* vp = newPrintHelper(vv, cv);
+            vp->setPartialSums(&psv.getSums());
             
             // Stencil-calculation code.
             // Function header.
@@ -591,27 +960,45 @@ void YASKCppPrinter::printCode(ostream& os) {
             os << " // There are " << (fpops.getNumOps() * numResults) <<
                 " FP operation(s) per cluster." << endl;
 
-            os << " void calc_cluster(" << _context << "& context, " <<
-                _dimCounts.makeDimStr(", ", "idx_t ", "v") << ") {" << endl;
-
-            // Element indices.
-            os << endl << " // Un-normalized indices." << endl;
-            for (auto dim : _dimCounts.getDims()) {
-                auto p = _foldLengths.lookup(dim);
-                os << " idx_t " << dim << " = " << dim << "v";
-                if (p) os << " * " << *p;
-                os << ";" << endl;
-            }
+            // Full clusters, then partial clusters at the end of the domain.
+            // The latter only write the elements selected by the masks.
+            for (int masked = 0; masked < 2; masked++) {
+                CppVecPrintHelper* cvp = vp;
+                if (masked) {
+                    os << endl << " // Same as calc_cluster(), but only writes results selected by cmask." << endl;
+                    cvp = newPrintHelper(vv, cv);
+                    cvp->setPartialSums(&psv.getSums());
+                    cvp->setMaskWrites(true);
+                }
+                os << " template <typename ContextClass>" << endl <<
+                    " void calc_cluster" << (masked ? "_masked" : "") << "(ContextClass& context, " <<
+                    _dimCounts.makeDimStr(", ", "idx_t ", "v");
+                if (masked)
+                    os << ", const ClusterMask& cmask";
+                os << ") {" << endl;
+
+                // Element indices.
+                os << endl << " // Un-normalized indices." << endl;
+                for (auto dim : _dimCounts.getDims()) {
+                    auto p = _foldLengths.lookup(dim);
+                    os << " idx_t " << dim << " = " << dim << "v";
+                    if (p) os << " * " << *p;
+                    os << ";" << endl;
+                }
                 
-            // Code generator visitor.
-            // The visitor is accepted at all nodes in the AST;
-            // for each node in the AST, code is generated and
-            // stored in the expression-string in the visitor.
-            PrintVisitorBottomUp pcv(os, *vp, _exprSize);
-            eq.grids.acceptToAll(&pcv);
+                // Code generator visitor.
+                // The visitor is accepted at all nodes in the AST;
+                // for each node in the AST, code is generated and
+                // stored in the expression-string in the visitor.
+                PrintVisitorBottomUp pcv(os, *cvp, _exprSize);
+                eq.grids.acceptToAll(&pcv);
 
-            // End of function.
-            os << "} // vector calculation." << endl;
+                // End of function.
+                os << "} // vector calculation." << endl;
+
+                if (masked)
+                    delete cvp;
+            }
 
             // Generate prefetch code for no specific direction and then each
             // orthogonal direction.
@@ -642,10 +1029,10 @@ void YASKCppPrinter::printCode(ostream& os) {
                     _foldLengths.makeDimValStr(" * ") << "' vector(s)." << endl;
                 os << " // Indices must be normalized, i.e., already divided by VLEN_*." << endl;
 
-                os << " template<int level> void prefetch_cluster";
+                os << " template<int level, typename ContextClass> void prefetch_cluster";
                 if (dir.size())
                     os << "_" << dir.getDirName();
-                os << "(" << _context << "& context, " <<
+                os << "(ContextClass& context, " <<
                     _dimCounts.makeDimStr(", ", "idx_t ", "v") << ") {" << endl;
 
                 // C++ prefetch code.
@@ -656,9 +1043,107 @@ void YASKCppPrinter::printCode(ostream& os) {
 
             } // direction.
 
+            // Generate pipelined calculation code for each non-time
+            // direction. Aligned vectors are kept in 'pipe' between
+            // consecutive clusters, so only the vectors that don't overlap
+            // the previous cluster are read from memory.
+            for (auto dim : _dimCounts.getDims()) {
+                if (dim == "t")
+                    continue;
+                IntTuple dir;
+                dir.addDim(dim, 1);
+                int step = _clusterLengths.getVal(dim);
+                auto p = _foldLengths.lookup(dim);
+                if (p) step *= *p;
+
+                vector<GridPoint> pipeVecs;
+                vector<int> pipeSrcs;
+                vv.getPipeline(pipeVecs, pipeSrcs, dir, step);
+
+                // Pipeline type.
+                os << endl << " // Aligned vector block(s) kept between clusters in the '+" <<
+                    dim << "' direction." << endl;
+                os << " struct Pipe_" << dim << " { real_vec_t v[" <<
+                    max<size_t>(pipeVecs.size(), 1) << "]; };" << endl;
+
+                // Priming and loading functions.
+                for (int prime = 1; prime >= 0; prime--) {
+                    os << endl << " // " << (prime ? "Prime" : "Load") << " pipeline in '+" <<
+                        dim << "' direction for the cluster at indices " <<
+                        _dimCounts.makeDimStr(", ") << "." << endl;
+                    if (prime)
+                        os << " // Called for the cluster before the first one in a loop." << endl;
+                    os << " // Indices must be normalized, i.e., already divided by VLEN_*." << endl;
+                    os << " template <typename ContextClass>" << endl <<
+                        " void " << (prime ? "prime" : "load") << "_pipe_" << dim <<
+                        "(ContextClass& context, Pipe_" << dim << "& pipe, " <<
+                        _dimCounts.makeDimStr(", ", "idx_t ", "v") << ") {" << endl;
+                    CppVecPrintHelper* lvp = newPrintHelper(vv, cv);
+                    lvp->setPartialSums(&psv.getSums());
+                    lvp->printPipeLoads(os, pipeVecs, pipeSrcs, prime != 0);
+                    os << "}" << endl;
+                    delete lvp;
+                }
+
+                // Calculation function.
+                os << endl << " // Same as calc_cluster(), but aligned vectors are read from 'pipe'," << endl <<
+                    " // which must already be loaded for this cluster." << endl;
+                os << " template <typename ContextClass>" << endl <<
+                    " void calc_pipe_cluster_" << dim << "(ContextClass& context, Pipe_" <<
+                    dim << "& pipe, " << _dimCounts.makeDimStr(", ", "idx_t ", "v") << ") {" << endl;
+                os << endl << " // Un-normalized indices." << endl;
+                for (auto dim2 : _dimCounts.getDims()) {
+                    auto p2 = _foldLengths.lookup(dim2);
+                    os << " idx_t " << dim2 << " = " << dim2 << "v";
+                    if (p2) os << " * " << *p2;
+                    os << ";" << endl;
+                }
+                map<GridPoint, string> pipePoints;
+                for (size_t i = 0; i < pipeVecs.size(); i++)
+                    pipePoints[pipeVecs[i]] = "pipe.v[" + to_string(i) + "]";
+                CppVecPrintHelper* pvp = newPrintHelper(vv, cv);
+                pvp->setPartialSums(&psv.getSums());
+                pvp->setReadyPoints(pipePoints);
+                PrintVisitorBottomUp pcv(os, *pvp, _exprSize);
+                eq.grids.acceptToAll(&pcv);
+                os << "} // pipelined vector calculation." << endl;
+                delete pvp;
+            } // direction.
+
             delete vp;
         }
 
+        // Interior cluster code.
+        // Same as calc_cluster() unless some grids have interior values.
+        os << endl << " // Calculate results in a cluster inside the interior of the domain," << endl <<
+            " // where grids with interior values are assumed to have those values." << endl;
+        os << " template <typename ContextClass>" << endl <<
+            " void calc_cluster_interior(ContextClass& context, " <<
+            _dimCounts.makeDimStr(", ", "idx_t ", "v") << ") {" << endl;
+        if (!eq.grids.hasInteriorExprs())
+            os << "  calc_cluster(context, " << _dimCounts.makeDimStr(", ", "", "v") << ");" << endl;
+        else {
+            VecInfoVisitor vv(_foldLengths);
+            eq.grids.acceptToAll(&vv, true);
+            ExprReorderVisitor erv(vv);
+            eq.grids.acceptToAll(&erv, true);
+            CounterVisitor cv;
+            eq.grids.acceptToAll(&cv, true);
+            CppVecPrintHelper* vp = newPrintHelper(vv, cv);
+
+            os << endl << " // Un-normalized indices." << endl;
+            for (auto dim : _dimCounts.getDims()) {
+                auto p = _foldLengths.lookup(dim);
+                os << " idx_t " << dim << " = " << dim << "v";
+                if (p) os << " * " << *p;
+                os << ";" << endl;
+            }
+            PrintVisitorBottomUp pcv(os, *vp, _exprSize);
+            eq.grids.acceptToAll(&pcv, true);
+            delete vp;
+        }
+        os << "} // interior vector calculation." << endl;
+
         os << "};" << endl; // end of class.
             
     } // stencil equations.
@@ -672,8 +1157,8 @@ void YASKCppPrinter::printCode(ostream& os) {
     // Stencil equation objects.
     os << endl << " // Stencils." << endl;
     for (auto& eq : _equations)
-        os << " StencilTemplate<Stencil_" << eq.name << "," <<
-            _context << "> stencil_" << eq.name << ";" << endl;
+        os << " StencilTemplate<Stencil_" << eq.name <<
+            ",ContextClass> stencil_" << eq.name << ";" << endl;
 
     // Ctor.
     os << endl << " StencilEquations_" << _stencil.getName() << "() {" << endl <<
@@ -682,6 +1167,8 @@ void YASKCppPrinter::printCode(ostream& os) {
     // Push stencils to list.
     for (auto& eq : _equations)
         os << "  stencils.push_back(&stencil_" << eq.name << ");" << endl;
+    if (_equations.getFuse())
+        os << "  fuse_eqs = true;" << endl;
     os << " }" << endl;
 
     os << "};" << endl;
@@ -700,9 +1187,11 @@ void YASKCppPrinter::printMacros(ostream& os) {
     os << "// Stencil:" << endl;
     os << "#define STENCIL_NAME \"" << _stencil.getName() << "\"" << endl;
     os << "#define STENCIL_IS_" << allCaps(_stencil.getName()) << " (1)" << endl;
-    os << "#define STENCIL_CONTEXT " << _context << endl;
+    os << "#define STENCIL_CONTEXT_TEMPLATE " << _context << endl;
+    os << "#define STENCIL_EQUATIONS_TEMPLATE StencilEquations_" << _stencil.getName() << endl;
+    os << "#define STENCIL_CONTEXT " << _context << "<>" << endl;
     os << "#define STENCIL_EQUATIONS StencilEquations_" << _stencil.getName() <<
-        "<" << _context << ">" << endl;
+        "<" << _context << "<> >" << endl;
 
     os << endl;
     os << "// Dimensions:" << endl;
@@ -730,4 +1219,13 @@ void YASKCppPrinter::printMacros(ostream& os) {
         os << "#define CLEN_" << ucDim << " (" << _clusterLengths.getVal(dim) << ")" << endl;
     }
     os << "#define CLEN (" << _clusterLengths.product() << ")" << endl;
+
+    // Time slots.
+    int maxSlots = 1;
+    for (auto gp : _grids)
+        if (gp->lookup("t"))
+            maxSlots = max(maxSlots, gp->getTimeSlots());
+    os << endl;
+    os << "// Max number of time-step slots needed by any grid." << endl;
+    os << "#define MAX_TIME_SLOTS (" << maxSlots << ")" << endl;
 }
@@ -122,6 +122,19 @@ public:
     virtual string writeToPoint(ostream& os, const GridPoint& gp, const string& val) {
         return gp.makeStr() + " = " + val;
     }
+
+    // Whether to fuse products into sums and differences.
+    virtual bool useFma() const { return false; }
+
+    // Return a fused multiply-add, 'a * b + c'.
+    // If 'negProd' is set, the product is negated;
+    // if 'negAddend' is set, 'c' is negated.
+    virtual string makeFma(const string& a, const string& b, const string& c,
+                           bool negProd = false, bool negAddend = false) {
+        assert(!(negProd && negAddend));
+        return "(" + string(negProd ? "-" : "") + a + " * " + b +
+            (negAddend ? " - " : " + ") + c + ")";
+    }
 };
 
 // Base class for a print visitor.
@@ -154,6 +167,16 @@ public:
         _exprStr = "";
         return v;
     }
+
+    // Return 'ep' as a product to fuse into an FMA, or NULL.
+    // Shared products are fused, too: an FMA costs no more than
+    // the add it replaces, and this keeps the rounding independent
+    // of the sharing, which differs between scalar and vector code.
+    virtual CommutativeExpr* getFusableProduct(const ExprPtr& ep) {
+        if (!_ph.useFma())
+            return NULL;
+        return getFmaProduct(ep);
+    }
 };
 
 // Outputs a simple, human-readable version of the AST
@@ -161,6 +184,12 @@ public:
 // and anything 'left over' will be left in '_exprStr'.
 class PrintVisitorTopDown : public PrintVisitorBase {
     int _numCommon;
+
+    // Return expr for 'ep' without adding it to _exprStr.
+    string getOperandStr(ExprPtr& ep);
+
+    // Set the operands for an FMA of 'prod'.
+    void getFmaOps(CommutativeExpr* prod, string& a, string& b);
     
 public:
     PrintVisitorTopDown(ostream& os, PrintHelper& ph) :
@@ -214,6 +243,10 @@ protected:
     // Return stream to continue w/RHS.
     virtual ostream& makeNextTempVar(Expr* ex, string comment = "");
 
+    // Set the operands for an FMA of 'prod'.
+    // Prints all but the last factor as a separate product.
+    virtual void getFmaOps(CommutativeExpr* prod, string& a, string& b);
+
 public:
     // os is used for printing intermediate results as needed.
     PrintVisitorBottomUp(ostream& os, PrintHelper& ph,
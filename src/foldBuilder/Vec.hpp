@@ -209,6 +209,45 @@ public:
         }
     }
 
+    // Get the aligned vectors sorted by their offsets in the given
+    // direction, and, for each one, the index of the vector whose value
+    // it takes when the cluster moves 'step' elements in that direction.
+    // The index is -1 if there is no such vector, i.e., if it must be
+    // read from memory. If there are no gaps in the stencil in that
+    // direction, these are the ones from getLeadingEdge().
+    // Pre-requisite: visitor has been accepted.
+    virtual void getPipeline(vector<GridPoint>& vecs, vector<int>& srcs,
+                             const IntTuple& dir, int step) const {
+        string dname = dir.getDirName();
+        vecs.assign(_alignedVecs.begin(), _alignedVecs.end());
+        stable_sort(vecs.begin(), vecs.end(),
+                    [&](const GridPoint& a, const GridPoint& b) {
+                        const int* ap = a.lookup(dname);
+                        const int* bp = b.lookup(dname);
+                        return (ap ? *ap : 0) < (bp ? *bp : 0);
+                    });
+
+        srcs.clear();
+        for (size_t i = 0; i < vecs.size(); i++) {
+
+            // A vector w/o this dim doesn't change.
+            int src = -1;
+            const int* p = vecs[i].lookup(dname);
+            if (!p)
+                src = i;
+
+            // Look for the one 'step' ahead.
+            else {
+                GridPoint ahead(vecs[i]);
+                ahead.setVal(dname, *p + step);
+                for (size_t j = i + 1; j < vecs.size(); j++)
+                    if (vecs[j] == ahead)
+                        src = j;
+            }
+            srcs.push_back(src);
+        }
+    }
+
     // Only want to visit the RHS of an equation.
     // Assumes LHS is aligned.
     // TODO: validate this.
@@ -294,6 +333,46 @@ public:
     }                   // end of visit() method.
 };
 
+// A weighted sum of points in one grid along one dim, created by
+// PartialSumVisitor. Its value at a point p in the partial-sum grid is
+// the sum over i of weights[i] * grid(p + offsets[i]), where the offsets
+// are in 'dim' only and are multiples of the fold length in 'dim'.
+struct PartialSum {
+    Grid* grid;                 // grid being summed.
+    string dim;                 // direction of offsets.
+    vector<int> offsets;        // offsets in 'dim'.
+    ExprPtrVec weights;         // scalar weights; NULL for 1.
+
+    // Make an expression for the value at 'gp', which must be
+    // a point in the partial-sum grid.
+    ExprPtr makeExpr(const GridPoint& gp) const {
+        auto sum = make_shared<AddExpr>();
+        for (size_t i = 0; i < offsets.size(); i++) {
+            IntTuple pt = gp;
+            pt.setVal(dim, pt.getVal(dim) + offsets[i]);
+            ExprPtr term = make_shared<GridPoint>(grid, pt);
+            if (weights[i]) {
+                auto prod = make_shared<MultExpr>();
+                prod->getOps().push_back(weights[i]);
+                prod->getOps().push_back(term);
+                term = prod;
+            }
+            sum->getOps().push_back(term);
+        }
+        return sum;
+    }
+
+    // Add the points in 'grid' read to get the value at 'gp'.
+    void getPoints(GridPointSet& pts, const GridPoint& gp) const {
+        for (auto ofs : offsets) {
+            IntTuple pt = gp;
+            pt.setVal(dim, pt.getVal(dim) + ofs);
+            pts.insert(GridPoint(grid, pt));
+        }
+    }
+};
+typedef map<string, PartialSum> PartialSums; // key is partial-sum grid name.
+
 // Define methods for printing a vectorized version of the stencil.
 class VecPrintHelper : public PrintHelper {
 protected:
@@ -302,6 +381,8 @@ protected:
     bool _reuseVars; // if true, load to a local var; else, reload on every access.
     bool _definedNA;           // NA var defined.
     map<GridPoint, string> _readyPoints; // points that are already constructed.
+    const PartialSums* _partialSums; // grids that are computed, not read.
+    GridPointSet _sumPoints;         // aligned points read by partial sums.
 
     // Print access to an aligned vector block.
     // Return var name.
@@ -335,7 +416,7 @@ public:
                    bool reuseVars = true) :
         PrintHelper(cv, varPrefix, varType, linePrefix, lineSuffix),
         _vv(vv), _allowUnalignedLoads(allowUnalignedLoads),
-        _reuseVars(reuseVars), _definedNA(false) { }
+        _reuseVars(reuseVars), _definedNA(false), _partialSums(NULL) { }
     virtual ~VecPrintHelper() {}
 
     // get fold info.
@@ -343,6 +424,50 @@ public:
         return _vv.getFold();
     }
 
+    // Set vars that already hold some points, e.g.,
+    // aligned vectors kept in a pipeline.
+    virtual void setReadyPoints(const map<GridPoint, string>& readyPoints) {
+        _readyPoints = readyPoints;
+    }
+
+    // Set grids created by PartialSumVisitor.
+    virtual void setPartialSums(const PartialSums* partialSums) {
+        _partialSums = partialSums;
+    }
+
+    // Determine whether gp is in a partial-sum grid.
+    virtual bool isPartialSum(const GridPoint& gp) const {
+        return _partialSums && _partialSums->count(gp.getName());
+    }
+
+    // Print the calculation of an aligned vector block in a partial-sum grid.
+    // Return var name.
+    virtual string printPartialSum(ostream& os, const GridPoint& gp) {
+        auto& ps = _partialSums->at(gp.getName());
+        ExprPtr ep = ps.makeExpr(gp);
+
+        // The points summed are aligned, but they may not be read
+        // anywhere else.
+        ps.getPoints(_sumPoints, gp);
+        PrintVisitorTopDown pv(os, *this);
+        ep->accept(&pv);
+        string varName = makeVarName();
+        os << endl << " // Partial sum " << gp.getName() << " at " <<
+            gp.makeDimValOffsetStr() << "." << endl;
+        os << _linePrefix << _varType << " " << varName << " = " <<
+            pv.getExprStr() << _lineSuffix;
+        return varName;
+    }
+
+    // Determine whether gp has all dims of the fold that are >1.
+    virtual bool hasFoldDims(const GridPoint& gp) const {
+        const IntTuple& fold = getFold();
+        for (auto dim : fold.getDims())
+            if (fold.getVal(dim) > 1 && !gp.lookup(dim))
+                return false;
+        return true;
+    }
+
     // Add a N/A var, just for readability.
     virtual void makeNA(ostream& os) {
         if (!_definedNA) {
@@ -362,11 +487,15 @@ public:
             varName = _readyPoints[gp]; // do nothing.
 
         // An aligned vector block?
-        else if (_vv._alignedVecs.count(gp))
-            varName = printAlignedVecRead(os, gp);
+        else if (_vv._alignedVecs.count(gp) || _sumPoints.count(gp))
+            varName = isPartialSum(gp) ? printPartialSum(os, gp) :
+                printAlignedVecRead(os, gp);
 
         // Unaligned loads allowed?
-        else if (_allowUnalignedLoads)
+        // Not for grids missing a fold dim, e.g., 1D grids, because
+        // their vectors are broadcast across the missing dims,
+        // or for partial sums, which are not in memory.
+        else if (_allowUnalignedLoads && hasFoldDims(gp) && !isPartialSum(gp))
             varName = printUnalignedVecRead(os, gp);
 
         // Need to construct an unaligned vector block?
@@ -493,4 +622,239 @@ public:
     }
 };
 
+// A visitor that replaces sums of weighted points that are unaligned
+// along a folded dim with reads from partial-sum grids (semi-stencil).
+// Points in the same grid at the same offset modulo the fold length
+// share one partial sum, so one unaligned vector is built from two
+// aligned partial sums instead of one per point. Each aligned partial
+// sum is reused by the neighboring vector in a cluster or, when
+// pipelined, the next cluster.
+// Example with fold x=4: a*g(x-3) + b*g(x+1) => p(x+1),
+// where p(x) = a*g(x-4) + b*g(x).
+class PartialSumVisitor : public ExprVisitor {
+protected:
+    const IntTuple& _fold;
+    PartialSums _sums;
+    vector<shared_ptr<Grid>> _grids; // partial-sum grids.
+    map<string, string> _names;      // definition key -> grid name.
+
+    // A point read in a sum and the location of its term.
+    struct Term {
+        GridPoint* gp;
+        ExprPtr weight;         // NULL for 1.
+        int op, subOp;          // index in sum and in operand's own sum, if any.
+    };
+
+    // Determine whether ep is a scalar that doesn't vary by point.
+    static bool isScalar(const ExprPtr& ep) {
+        if (dynamic_cast<ConstExpr*>(ep.get()) || dynamic_cast<CodeExpr*>(ep.get()))
+            return true;
+        auto gp = dynamic_cast<GridPoint*>(ep.get());
+        return gp && gp->isParam();
+    }
+
+    // Determine whether gp may be in a partial sum.
+    bool isSummable(GridPoint* gp) const {
+        return !gp->isParam() && !_sums.count(gp->getName());
+    }
+
+    // Get the partial-sum grid for the given terms, which must all be in
+    // the same grid and have the same offset modulo 'fl' in 'dim'.
+    // Set 'ofs' to the offset in 'dim' of the partial-sum point to read.
+    Grid* getSumGrid(const vector<Term>& terms, const string& dim, int fl, int& ofs) {
+        Grid* grid = terms[0].gp->getGrid();
+        int k0 = terms[0].gp->getVal(dim);
+        int s = ((k0 % fl) + fl) % fl;
+        ofs = k0;
+        for (auto& t : terms)
+            ofs = min(ofs, t.gp->getVal(dim));
+
+        // Offsets from the partial-sum point are multiples of 'fl'.
+        PartialSum ps;
+        ps.grid = grid;
+        ps.dim = dim;
+        string key = grid->getName() + " " + dim;
+        for (auto& t : terms) {
+            ps.offsets.push_back(t.gp->getVal(dim) - ofs);
+            ps.weights.push_back(t.weight);
+            key += " " + to_string(ps.offsets.back()) + "*" +
+                (t.weight ? t.weight->makeStr() : "1");
+        }
+        assert((ofs - s) % fl == 0);
+
+        // Reuse an existing grid w/the same definition.
+        string& name = _names[key];
+        if (!name.length()) {
+            name = grid->getName() + "_psum" + to_string(_names.size());
+            auto sg = make_shared<Grid>();
+            sg->setName(name);
+            sg->setParam(false);
+            for (auto d : grid->getDims())
+                sg->addDim(d, grid->getVal(d));
+            _grids.push_back(sg);
+            _sums[name] = ps;
+        }
+        for (auto& sg : _grids)
+            if (sg->getName() == name)
+                return sg.get();
+        assert(0);
+        return NULL;
+    }
+
+public:
+    PartialSumVisitor(const IntTuple& fold) :
+        _fold(fold) { }
+    virtual ~PartialSumVisitor() {}
+
+    // Get the partial-sum grids created.
+    const PartialSums& getSums() const { return _sums; }
+
+    // Rewrite a sum before visiting its operands so that the largest
+    // sums are used.
+    virtual void visit(CommutativeExpr* ce) {
+        ExprPtrVec& ops = ce->getOps();
+        if (ce->getOpStr() == AddExpr::opStr()) {
+
+            // Find weighted points: g, w*g, and w*(g+...).
+            vector<Term> terms;
+            for (size_t i = 0; i < ops.size(); i++) {
+                auto gp = dynamic_cast<GridPoint*>(ops[i].get());
+                if (gp) {
+                    if (isSummable(gp))
+                        terms.push_back({ gp, NULL, int(i), -1 });
+                    continue;
+                }
+                auto prod = getFmaProduct(ops[i]);
+                if (!prod)
+                    continue;
+
+                // Need exactly one non-scalar factor.
+                ExprPtr other;
+                auto weight = make_shared<MultExpr>();
+                for (auto& op : prod->getOps()) {
+                    if (isScalar(op))
+                        weight->getOps().push_back(op);
+                    else if (other) {
+                        other = NULL;
+                        break;
+                    }
+                    else
+                        other = op;
+                }
+                if (!other)
+                    continue;
+                ExprPtr w = weight;
+                if (weight->getOps().size() == 1)
+                    w = weight->getOps()[0];
+                gp = dynamic_cast<GridPoint*>(other.get());
+                if (gp) {
+                    if (isSummable(gp))
+                        terms.push_back({ gp, w, int(i), -1 });
+                    continue;
+                }
+                auto sum = dynamic_cast<CommutativeExpr*>(other.get());
+                if (sum && sum->getOpStr() == AddExpr::opStr()) {
+                    auto& sops = sum->getOps();
+                    for (size_t j = 0; j < sops.size(); j++) {
+                        gp = dynamic_cast<GridPoint*>(sops[j].get());
+                        if (gp && isSummable(gp))
+                            terms.push_back({ gp, w, int(i), int(j) });
+                    }
+                }
+            }
+
+            // Group terms by grid, dim, offset modulo fold, and other offsets.
+            // A term is only used once, in the first dim it is unaligned in.
+            map<string, vector<Term>> groups;
+            map<string, string> groupDims;
+            set<size_t> used;
+            for (auto dim : _fold.getDims()) {
+                int fl = _fold.getVal(dim);
+                if (fl <= 1)
+                    continue;
+                map<string, vector<size_t>> dimGroups;
+                for (size_t i = 0; i < terms.size(); i++) {
+                    auto gp = terms[i].gp;
+                    if (used.count(i) || !gp->lookup(dim))
+                        continue;
+                    int k = gp->getVal(dim);
+                    int s = ((k % fl) + fl) % fl;
+                    if (s == 0)
+                        continue;
+                    IntTuple base = *gp;
+                    base.setVal(dim, s);
+                    dimGroups[gp->getName() + " " + dim + " " + base.makeDimValStr()].push_back(i);
+                }
+                for (auto& g : dimGroups) {
+                    if (g.second.size() < 2)
+                        continue;
+                    for (auto i : g.second) {
+                        used.insert(i);
+                        groups[g.first].push_back(terms[i]);
+                    }
+                    groupDims[g.first] = dim;
+                }
+            }
+
+            if (groups.size()) {
+
+                // Remove grouped terms.
+                map<int, set<int>> removed; // op -> sub-ops.
+                for (auto i : used)
+                    removed[terms[i].op].insert(terms[i].subOp);
+                ExprPtrVec nops;
+                for (size_t i = 0; i < ops.size(); i++) {
+                    auto ri = removed.find(int(i));
+                    if (ri == removed.end()) {
+                        nops.push_back(ops[i]);
+                        continue;
+                    }
+                    if (ri->second.count(-1))
+                        continue;
+
+                    // Make new w*(...) w/o the grouped points.
+                    // The old one may be shared, so it isn't changed.
+                    auto prod = getFmaProduct(ops[i]);
+                    auto nprod = make_shared<MultExpr>();
+                    bool empty = false;
+                    for (auto& op : prod->getOps()) {
+                        if (isScalar(op)) {
+                            nprod->getOps().push_back(op);
+                            continue;
+                        }
+                        auto nsum = make_shared<AddExpr>();
+                        auto& sops = dynamic_cast<CommutativeExpr*>(op.get())->getOps();
+                        for (size_t j = 0; j < sops.size(); j++)
+                            if (!ri->second.count(int(j)))
+                                nsum->getOps().push_back(sops[j]);
+                        if (nsum->getOps().size() == 1)
+                            nprod->getOps().push_back(nsum->getOps()[0]);
+                        else if (nsum->getOps().size() > 1)
+                            nprod->getOps().push_back(nsum);
+                        else
+                            empty = true;
+                    }
+                    if (!empty)
+                        nops.push_back(nprod);
+                }
+
+                // Add reads from the partial sums.
+                for (auto& g : groups) {
+                    string dim = groupDims[g.first];
+                    int ofs = 0;
+                    Grid* sg = getSumGrid(g.second, dim, _fold.getVal(dim), ofs);
+                    IntTuple pt = *g.second[0].gp;
+                    pt.setVal(dim, ofs);
+                    nops.push_back(make_shared<GridPoint>(sg, pt));
+                }
+                ops.swap(nops);
+            }
+        }
+
+        // Visit remaining operands.
+        for (auto& ep : ops)
+            ep->accept(this);
+    }
+};
+
 #endif
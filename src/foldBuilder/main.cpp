@@ -61,6 +61,11 @@ bool allowUnalignedLoads = false;
 string equationTargets;
 bool doComb = false;
 bool doCse = true;
+bool doPairs = true;
+bool doHoist = false;
+bool doRecip = false;
+bool doFuse = false;
+bool doSemi = false;
 
 void usage(const string& cmd) {
 
@@ -77,6 +82,7 @@ void usage(const string& cmd) {
         " -fold <dim>=<size>,...    set number of elements in each dimension in a vector block.\n"
         " -cluster <dim>=<size>,... set number of values to evaluate in each dimension.\n"
         " -eq <name>=<substr>,...   put updates to grids containing substring in equation name.\n"
+        "                           By default, equations are grouped based on grid dependencies.\n"
         " -or <order>        set stencil order (ignored for some stencils; default=" << order << ").\n"
         //" -dc                defer coefficient lookup to runtime (for iso3dfd stencil only).\n"
         " -lus               make last dimension of fold unit stride (instead of first).\n"
@@ -84,6 +90,16 @@ void usage(const string& cmd) {
         " -es <expr-size>    set heuristic for expression-size threshold (default=" << exprSize << ").\n"
         " -[no]comb          [do not] combine commutative operations (default=" << doComb << ").\n"
         " -[no]cse           [do not] eliminate common subexpressions (default=" << doCse << ").\n"
+        " -[no]pairs         [do not] share pairs of factors between products,\n"
+        "                      e.g., across grids updated by an equation (default=" << doPairs << ").\n"
+        " -[no]hoist         [do not] compute sub-exprs that read only time-invariant grids\n"
+        "                      and params once into derived grids (default=" << doHoist << ").\n"
+        " -[no]recip         [do not] replace divisions by constants and params with\n"
+        "                      multiplications by reciprocals (default=" << doRecip << ").\n"
+        " -[no]fuse          [do not] evaluate all equations in each region, skewed by the\n"
+        "                      wavefront angles, to reduce passes over the grids (default=" << doFuse << ").\n"
+        " -[no]semi          [do not] sum points that are unaligned by the same amount in a folded\n"
+        "                      dimension into partial sums of aligned vectors (default=" << doSemi << ").\n"
         "\n"
         //" -ps <vec-len>      print stats for all folding options for given vector length.\n"
         " -ph                print human-readable scalar pseudo-code for one point.\n"
@@ -134,6 +150,26 @@ void parseOpts(int argc, const char* argv[])
                 doCse = true;
             else if (opt == "-nocse")
                 doCse = false;
+            else if (opt == "-pairs")
+                doPairs = true;
+            else if (opt == "-nopairs")
+                doPairs = false;
+            else if (opt == "-hoist")
+                doHoist = true;
+            else if (opt == "-nohoist")
+                doHoist = false;
+            else if (opt == "-recip")
+                doRecip = true;
+            else if (opt == "-norecip")
+                doRecip = false;
+            else if (opt == "-fuse")
+                doFuse = true;
+            else if (opt == "-nofuse")
+                doFuse = false;
+            else if (opt == "-semi")
+                doSemi = true;
+            else if (opt == "-nosemi")
+                doSemi = false;
             
             else if (opt == "-pm")
                 printMacros = true;
@@ -260,6 +296,7 @@ int main(int argc, const char* argv[]) {
     // Also keep count of how many grids have each dim.
     // Note that dimensions won't be in any particular order!
     IntTuple dimCounts;
+    int num1dGrids = 0;
     for (auto gp : grids) {
 
         // Count dimensions from this grid.
@@ -269,17 +306,26 @@ int main(int argc, const char* argv[]) {
             else
                 dimCounts.addDim(dim, 1);
         }
+
+        // Count 1D spatial grids.
+        if (gp->is1dSpatial())
+            num1dGrids++;
     }
 
     // For now, there are only global specifications for vector and cluster
     // sizes. Also, vector folding and clustering is done identially for
     // every grid access. Thus, sizes > 1 must exist in all grids.  So, init
     // vector and cluster sizes based on dimensions that appear in ALL
-    // grids.
+    // grids. 1D spatial grids are the exception: their vectors are
+    // broadcast across the other dimensions.
     // TODO: relax this restriction.
     IntTuple foldLengths, clusterLengths;
     for (auto dim : dimCounts.getDims()) {
-        if (dimCounts.getVal(dim) == (int)grids.size()) {
+        int n = dimCounts.getVal(dim) + num1dGrids;
+        for (auto gp : grids)
+            if (gp->is1dSpatial() && gp->lookup(dim))
+                n--;
+        if (n == (int)grids.size()) {
             foldLengths.addDim(dim, 1);
             clusterLengths.addDim(dim, 1);
         }
@@ -352,9 +398,66 @@ int main(int argc, const char* argv[]) {
             stencilFunc->define(offsets);
         });
 
+    // Keep the original equations for the reference code.
+    if (doHoist)
+        for (auto gp : grids)
+            gp->saveRefExpr();
+
+    // Replace time-invariant sub-exprs w/reads of derived grids.
+    HoistVisitor hoister(grids, params);
+    if (doHoist) {
+        grids.acceptToAll(&hoister);
+        for (auto dg : hoister.getDerived()) {
+            grids.push_back(dg.get());
+            auto ee = dynamic_pointer_cast<EqualsExpr>(dg->getDerivedExpr());
+            cerr << "Grid '" << dg->getName() << "' is derived from " <<
+                ee->getRhs()->makeStr() << "." << endl;
+        }
+    }
+
+    // Replace divisions by constants and params.
+    RecipVisitor recipper(grids, params);
+    if (doRecip) {
+        grids.acceptToAll(&recipper);
+
+        // Use the same reciprocals in the reference code, so that both
+        // round the same way.
+        for (auto gp : grids)
+            if (gp->getRefExpr())
+                gp->acceptToRef(&recipper);
+        for (auto dp : recipper.getDerived()) {
+            params.push_back(dp.get());
+            auto ee = dynamic_pointer_cast<EqualsExpr>(dp->getDerivedExpr());
+            cerr << "Param '" << dp->getName() << "' is derived from " <<
+                ee->getRhs()->makeStr() << "." << endl;
+        }
+    }
+
     // Extract equations from grids.
     Equations equations;
     equations.findEquations(grids, equationTargets);
+    equations.setFuse(doFuse);
+    equations.setSemiStencil(doSemi);
+
+    // Find wavefront angles in the spatial dims.
+    {
+        IntTuple clusterPts;
+        for (auto dim : dimCounts.getDims()) {
+            if (dim == "t")
+                continue;
+            const int* fp = foldLengths.lookup(dim);
+            const int* cp = clusterLengths.lookup(dim);
+            clusterPts.addDim(dim, (fp ? *fp : 1) * (cp ? *cp : 1));
+        }
+        equations.findAngles(clusterPts);
+    }
+
+    // Find time slots needed by each grid.
+    equations.findTimeSlots(grids);
+    for (auto gp : grids)
+        if (gp->lookup("t"))
+            cerr << "Grid '" << gp->getName() << "' needs " <<
+                gp->getTimeSlots() << " time slot(s)." << endl;
     equations.printInfo(cerr);
 
     // Get stats.
@@ -370,14 +473,22 @@ int main(int argc, const char* argv[]) {
     }
     
     // Make a list of optimizations to apply.
-    vector<OptVisitor*> opts;
-    if (doCse)
-        opts.push_back(new CseVisitor);
-    if (doComb) {
-        opts.push_back(new CombineVisitor);
+    auto makeOpts = [&]() {
+        vector<OptVisitor*> opts;
         if (doCse)
             opts.push_back(new CseVisitor);
-    }
+        if (doComb) {
+            opts.push_back(new CombineVisitor);
+            if (doCse)
+                opts.push_back(new CseVisitor);
+        }
+        if (doCse && doPairs) {
+            opts.push_back(new PairVisitor);
+            opts.push_back(new CseVisitor);
+        }
+        return opts;
+    };
+    vector<OptVisitor*> opts = makeOpts();
     
     // Apply opts.
     for (auto optimizer : opts) {
@@ -397,6 +508,27 @@ int main(int argc, const char* argv[]) {
             cerr << "No changes " << descr << '.' << endl;
     }
 
+    // Make interior versions of equations that read grids with
+    // interior values.
+    for (auto gp : grids) {
+        InteriorVisitor iv;
+        Point2Exprs iexprs;
+        for (auto i : gp->getExprs()) {
+            ExprPtr ep = i.second->clone();
+            ep->accept(&iv);
+            iexprs[i.first] = ep;
+        }
+        if (iv.getNumChanges())
+            gp->getInteriorExprs() = iexprs;
+    }
+    if (grids.hasInteriorExprs()) {
+        for (auto optimizer : makeOpts())
+            grids.acceptToAll(optimizer, true);
+        CounterVisitor cv;
+        grids.acceptToAll(&cv, true);
+        cv.printStats(cerr, "for interior of domain");
+    }
+    
     ///// Print out above data based on -p* option(s).
     
     // Human-readable output.
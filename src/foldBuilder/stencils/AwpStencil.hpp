@@ -43,9 +43,9 @@ protected:
     // 3D-spatial Lame' coefficients.
     Grid lambda, rho, mu;
 
-    // Sponge coefficients.
+    // Sponge coefficients, separable in each dimension.
     // (Most of these will be 1.0.)
-    Grid sponge;
+    Grid sponge_x, sponge_y, sponge_z;
 
     // Spatial FD coefficients.
     const double c1 = 9.0/8.0;
@@ -73,20 +73,24 @@ public:
         INIT_GRID_3D(lambda, x, y, z);
         INIT_GRID_3D(rho, x, y, z);
         INIT_GRID_3D(mu, x, y, z);
-        INIT_GRID_3D(sponge, x, y, z);
+        INIT_GRID_1D(sponge_x, x);
+        INIT_GRID_1D(sponge_y, y);
+        INIT_GRID_1D(sponge_z, z);
         INIT_PARAM(delta_t);
         INIT_PARAM(h);
+
+        // Sponge coefficients are 1.0 away from the boundary layer.
+        sponge_x.setInteriorValue(1.0);
+        sponge_y.setInteriorValue(1.0);
+        sponge_z.setInteriorValue(1.0);
     }
 
     // Adjustment for sponge layer.
     void adjust_for_sponge(GridValue& next_vel_x, GridIndex x, GridIndex y, GridIndex z) {
 
-        // TODO: It may be more efficient to skip processing interior nodes
-        // because their sponge coefficients are 1.0.  But this would
-        // necessitate handling conditionals. The branch mispredictions may
-        // cost more than the overhead of the extra loads and multiplies.
-
-        next_vel_x *= sponge(x, y, z);
+        // Interior kernels substitute 1.0 for the sponge coefficients,
+        // which removes the loads and multiplies in the interior.
+        next_vel_x *= sponge_x(x) * sponge_y(y) * sponge_z(z);
     }
 
     // Velocity-grid define functions.  For each D in x, y, z, define vel_D
@@ -245,3 +245,68 @@ public:
 };
 
 REGISTER_STENCIL(CubeStencil);
+
+// Add a flux grid that is only updated in a slab at the low-z boundary.
+// This illustrates an equation restricted to a sub-domain; its cost is
+// proportional to the volume of the slab, not the whole domain.
+class AxisFluxStencil : public AxisStencil {
+protected:
+    Grid flux;
+
+public:
+    AxisFluxStencil(StencilList& stencils, int order=2) :
+        AxisStencil("3axis_flux", stencils, order)
+    {
+        INIT_GRID_4D(flux, t, x, y, z);
+        flux.setSubDomain(SubDomain().lowSlab("z", 10));
+    }
+
+    // Define equations for grid and flux at t+1.
+    virtual void define(const IntTuple& offsets) {
+        AxisStencil::define(offsets);
+        GET_OFFSET(t);
+        GET_OFFSET(x);
+        GET_OFFSET(y);
+        GET_OFFSET(z);
+
+        flux(t+1, x, y, z) == flux(t, x, y, z) +
+            0.5 * (grid(t, x, y, z+1) - grid(t, x, y, z));
+    }
+};
+
+REGISTER_STENCIL(AxisFluxStencil);
+
+// Two equations that read the same sum of points in a time-invariant
+// grid. After common-subexpr elimination, the sum is shared between
+// the equations, so this checks that passes that change the
+// expressions of one equation, e.g., '-semi', don't change the other.
+class SharedSumStencil : public StencilBase {
+protected:
+    Grid u, v;                  // time-varying grids.
+    Grid c;                     // coefficients.
+
+public:
+    SharedSumStencil(StencilList& stencils) :
+        StencilBase("shared_sum", stencils)
+    {
+        INIT_GRID_4D(u, t, x, y, z);
+        INIT_GRID_4D(v, t, x, y, z);
+        INIT_GRID_3D(c, x, y, z);
+    }
+
+    // Define equations for u and v at t+1.
+    // The one for v reads u at t+1, so they are separate equations.
+    virtual void define(const IntTuple& offsets) {
+        GET_OFFSET(t);
+        GET_OFFSET(x);
+        GET_OFFSET(y);
+        GET_OFFSET(z);
+
+        u(t+1, x, y, z) == 0.25 *
+            (c(x-3, y, z) + c(x+1, y, z) + c(x, y, z));
+        v(t+1, x, y, z) == 0.5 * v(t, x, y, z) + u(t+1, x, y, z) *
+            (c(x-3, y, z) + c(x+1, y, z) + c(x, y, z));
+    }
+};
+
+REGISTER_STENCIL(SharedSumStencil);
@@ -1,6 +1,552 @@
-#include "generic_grids.hpp"
+/*****************************************************************************
 
-GenericGrid1d<int, Layout1> g1d(10);
-GenericGrid2d<float, Layout21> g2d(6,7);
-GenericGrid3d<float, Layout321> g3d(5,6,7);
-GenericGrid4d<double, Layout3421> g4d(4,5,6,7);
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2016, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+// Correctness tests and access benchmarks for the grid layouts.
+// Every Layout_* class generated by gen-layouts.pl is checked in
+// GenericGrid1d-4d and RealVecGrid_* to make sure that each index maps to
+// a unique element and that layout() and unlayout() are inverses.
+// Then, copy throughput is measured for each layout with the innermost
+// loop in z (the order used by the stencil block loops) and in x, to
+// help choose layout_3d and layout_4d.
+
+#include "stencil.hpp"
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+using namespace yask;
+
+#define STR2(s) #s
+#define STR(s) STR2(s)
+
+// Total number of failed checks.
+idx_t num_errs = 0;
+
+// Report a failed check.
+// Only the first few are printed.
+void checkFailed(const string& what, const string& where) {
+    const idx_t maxPrint = 20;
+    num_errs++;
+    if (num_errs < maxPrint)
+        cerr << "** mismatch in " << what << " at " << where << endl;
+    else if (num_errs == maxPrint)
+        cerr << "** Additional errors not printed." << endl;
+}
+
+string idxStr(idx_t i, idx_t j) {
+    ostringstream oss;
+    oss << "(" << i << ", " << j << ")";
+    return oss.str();
+}
+string idxStr(idx_t i, idx_t j, idx_t k) {
+    ostringstream oss;
+    oss << "(" << i << ", " << j << ", " << k << ")";
+    return oss.str();
+}
+string idxStr(idx_t i, idx_t j, idx_t k, idx_t l) {
+    ostringstream oss;
+    oss << "(" << i << ", " << j << ", " << k << ", " << l << ")";
+    return oss.str();
+}
+string idxStr(idx_t i, idx_t j, idx_t k, idx_t l, idx_t m) {
+    ostringstream oss;
+    oss << "(" << i << ", " << j << ", " << k << ", " << l << ", " << m << ")";
+    return oss.str();
+}
+
+////// Generic-grid checks.
+// Each element is set to its row-major index via operator().
+// Then, every allocated element is visited in storage order and
+// unlayout() is used to find the indices that should have been
+// stored there. This fails if any element was not written, written
+// twice, or does not round-trip through layout() and unlayout().
+
+template <typename LayoutFn>
+void checkGrid1d(const string& name, idx_t d1) {
+    GenericGrid1d<idx_t, LayoutFn> g(d1);
+    LayoutFn lf(d1);
+    g.set_same(-1);
+    for (idx_t i = 0; i < d1; i++)
+        g(i) = i;
+    for (idx_t ai = 0; ai < g.get_num_elems(); ai++) {
+        idx_t i;
+        lf.unlayout(ai, i);
+        if (lf.layout(i) != ai || g.getRawData()[ai] != i)
+            checkFailed("GenericGrid1d<" + name + ">", to_string(ai));
+    }
+}
+
+template <typename LayoutFn>
+void checkGrid2d(const string& name, idx_t d1, idx_t d2) {
+    GenericGrid2d<idx_t, LayoutFn> g(d1, d2);
+    LayoutFn lf(d1, d2);
+    g.set_same(-1);
+    for (idx_t i = 0; i < d1; i++)
+        for (idx_t j = 0; j < d2; j++)
+            g(i, j) = i * d2 + j;
+    for (idx_t ai = 0; ai < g.get_num_elems(); ai++) {
+        idx_t i, j;
+        lf.unlayout(ai, i, j);
+        if (lf.layout(i, j) != ai || g.getRawData()[ai] != i * d2 + j)
+            checkFailed("GenericGrid2d<" + name + ">", idxStr(i, j));
+    }
+}
+
+template <typename LayoutFn>
+void checkGrid3d(const string& name, idx_t d1, idx_t d2, idx_t d3) {
+    GenericGrid3d<idx_t, LayoutFn> g(d1, d2, d3);
+    LayoutFn lf(d1, d2, d3);
+    g.set_same(-1);
+    for (idx_t i = 0; i < d1; i++)
+        for (idx_t j = 0; j < d2; j++)
+            for (idx_t k = 0; k < d3; k++)
+                g(i, j, k) = (i * d2 + j) * d3 + k;
+    for (idx_t ai = 0; ai < g.get_num_elems(); ai++) {
+        idx_t i, j, k;
+        lf.unlayout(ai, i, j, k);
+        if (lf.layout(i, j, k) != ai ||
+            g.getRawData()[ai] != (i * d2 + j) * d3 + k)
+            checkFailed("GenericGrid3d<" + name + ">", idxStr(i, j, k));
+    }
+}
+
+template <typename LayoutFn>
+void checkGrid4d(const string& name, idx_t d1, idx_t d2, idx_t d3, idx_t d4) {
+    GenericGrid4d<idx_t, LayoutFn> g(d1, d2, d3, d4);
+    LayoutFn lf(d1, d2, d3, d4);
+    g.set_same(-1);
+    for (idx_t i = 0; i < d1; i++)
+        for (idx_t j = 0; j < d2; j++)
+            for (idx_t k = 0; k < d3; k++)
+                for (idx_t l = 0; l < d4; l++)
+                    g(i, j, k, l) = ((i * d2 + j) * d3 + k) * d4 + l;
+    for (idx_t ai = 0; ai < g.get_num_elems(); ai++) {
+        idx_t i, j, k, l;
+        lf.unlayout(ai, i, j, k, l);
+        if (lf.layout(i, j, k, l) != ai ||
+            g.getRawData()[ai] != ((i * d2 + j) * d3 + k) * d4 + l)
+            checkFailed("GenericGrid4d<" + name + ">", idxStr(i, j, k, l));
+    }
+}
+
+////// Real-vector-grid checks.
+// Each element, including padding, is written via writeElem() with a
+// unique value and read back via readElem() and readVecNorm().
+// All reals in the allocation must be written exactly once.
+
+// Count reals in 'g' that are still 'val'.
+idx_t countSame(const RealVecGridBase& g, real_t val) {
+    idx_t n = 0;
+    const real_vec_t* vp = g.getRawData();
+    for (idx_t ai = 0; ai < g.get_num_real_vecs(); ai++)
+        for (int e = 0; e < VLEN; e++)
+            if (vp[ai][e] == val)
+                n++;
+    return n;
+}
+
+template <typename LayoutFn>
+void checkRealVecGridXYZ(const string& name, idx_t d) {
+    ostringstream msgs;
+    RealVecGrid_XYZ<LayoutFn> g(d, d + 1, d + 2, 1, 2, 3, name, msgs);
+    idx_t dx = g.get_dx(), dy = g.get_dy(), dz = g.get_dz();
+    idx_t px = g.get_px(), py = g.get_py(), pz = g.get_pz();
+    string what = "RealVecGrid_XYZ<" + name + ">";
+    g.set_same(-1);
+
+    // Unique non-negative value for each point.
+    auto val = [&](idx_t i, idx_t j, idx_t k) {
+        return real_t((((i + px) * (dy + 2 * py)) + j + py) * (dz + 2 * pz) + k + pz);
+    };
+    for (idx_t i = -px; i < dx + px; i++)
+        for (idx_t j = -py; j < dy + py; j++)
+            for (idx_t k = -pz; k < dz + pz; k++)
+                g.writeElem(val(i, j, k), i, j, k, __LINE__);
+    if (countSame(g, -1))
+        checkFailed(what, "unwritten elements");
+    for (idx_t i = -px; i < dx + px; i++)
+        for (idx_t j = -py; j < dy + py; j++)
+            for (idx_t k = -pz; k < dz + pz; k++)
+                if (g.readElem(i, j, k, __LINE__) != val(i, j, k))
+                    checkFailed(what + " readElem", idxStr(i, j, k));
+
+    // Compare elements in each vector.
+    for (idx_t iv = -px / VLEN_X; iv < (dx + px) / VLEN_X; iv++)
+        for (idx_t jv = -py / VLEN_Y; jv < (dy + py) / VLEN_Y; jv++)
+            for (idx_t kv = -pz / VLEN_Z; kv < (dz + pz) / VLEN_Z; kv++) {
+                real_vec_t v = g.readVecNorm(iv, jv, kv, __LINE__);
+                for (int ie = 0; ie < VLEN_X; ie++)
+                    for (int je = 0; je < VLEN_Y; je++)
+                        for (int ke = 0; ke < VLEN_Z; ke++) {
+                            idx_t i = iv * VLEN_X + ie;
+                            idx_t j = jv * VLEN_Y + je;
+                            idx_t k = kv * VLEN_Z + ke;
+                            if (v(0, ie, je, ke) != val(i, j, k))
+                                checkFailed(what + " readVecNorm", idxStr(i, j, k));
+                        }
+            }
+}
+
+template <typename LayoutFn>
+void checkRealVecGridNXYZ(const string& name, idx_t d) {
+    ostringstream msgs;
+    RealVecGrid_NXYZ<LayoutFn> g(3, d, d + 1, d + 2, 1, 1, 2, 3, name, msgs);
+    idx_t dn = g.get_dn(), dx = g.get_dx(), dy = g.get_dy(), dz = g.get_dz();
+    idx_t pn = g.get_pn(), px = g.get_px(), py = g.get_py(), pz = g.get_pz();
+    string what = "RealVecGrid_NXYZ<" + name + ">";
+    g.set_same(-1);
+
+    auto val = [&](idx_t n, idx_t i, idx_t j, idx_t k) {
+        return real_t(((((n + pn) * (dx + 2 * px) + i + px) *
+                        (dy + 2 * py)) + j + py) * (dz + 2 * pz) + k + pz);
+    };
+    for (idx_t n = -pn; n < dn + pn; n++)
+        for (idx_t i = -px; i < dx + px; i++)
+            for (idx_t j = -py; j < dy + py; j++)
+                for (idx_t k = -pz; k < dz + pz; k++)
+                    g.writeElem(val(n, i, j, k), n, i, j, k, __LINE__);
+    if (countSame(g, -1))
+        checkFailed(what, "unwritten elements");
+    for (idx_t n = -pn; n < dn + pn; n++)
+        for (idx_t i = -px; i < dx + px; i++)
+            for (idx_t j = -py; j < dy + py; j++)
+                for (idx_t k = -pz; k < dz + pz; k++)
+                    if (g.readElem(n, i, j, k, __LINE__) != val(n, i, j, k))
+                        checkFailed(what + " readElem", idxStr(n, i, j, k));
+
+    // Compare elements in each vector.
+    for (idx_t nv = -pn / VLEN_N; nv < (dn + pn) / VLEN_N; nv++)
+        for (idx_t iv = -px / VLEN_X; iv < (dx + px) / VLEN_X; iv++)
+            for (idx_t jv = -py / VLEN_Y; jv < (dy + py) / VLEN_Y; jv++)
+                for (idx_t kv = -pz / VLEN_Z; kv < (dz + pz) / VLEN_Z; kv++) {
+                    real_vec_t v = g.readVecNorm(nv, iv, jv, kv, __LINE__);
+                    for (int ne = 0; ne < VLEN_N; ne++)
+                        for (int ie = 0; ie < VLEN_X; ie++)
+                            for (int je = 0; je < VLEN_Y; je++)
+                                for (int ke = 0; ke < VLEN_Z; ke++) {
+                                    idx_t n = nv * VLEN_N + ne;
+                                    idx_t i = iv * VLEN_X + ie;
+                                    idx_t j = jv * VLEN_Y + je;
+                                    idx_t k = kv * VLEN_Z + ke;
+                                    if (v(ne, ie, je, ke) != val(n, i, j, k))
+                                        checkFailed(what + " readVecNorm", idxStr(n, i, j, k));
+                                }
+                }
+}
+
+// The T grids wrap time indices, so writing at t and reading back at
+// t + TIME_DIM_SIZE must give the same value.
+template <typename LayoutFn>
+void checkRealVecGridTXYZ(const string& name, idx_t d) {
+    ostringstream msgs;
+    RealVecGrid_TXYZ<LayoutFn> g(d, d + 1, d + 2, 1, 2, 3, name, msgs);
+    idx_t dx = g.get_dx(), dy = g.get_dy(), dz = g.get_dz();
+    idx_t px = g.get_px(), py = g.get_py(), pz = g.get_pz();
+    string what = "RealVecGrid_TXYZ<" + name + ">";
+    g.set_same(-1);
+
+    auto val = [&](idx_t t, idx_t i, idx_t j, idx_t k) {
+        return real_t((((t * (dx + 2 * px) + i + px) *
+                        (dy + 2 * py)) + j + py) * (dz + 2 * pz) + k + pz);
+    };
+    for (idx_t t = 0; t < TIME_DIM_SIZE; t++)
+        for (idx_t i = -px; i < dx + px; i++)
+            for (idx_t j = -py; j < dy + py; j++)
+                for (idx_t k = -pz; k < dz + pz; k++)
+                    g.writeElem(val(t, i, j, k), t * CPTS_T, i, j, k, __LINE__);
+    if (countSame(g, -1))
+        checkFailed(what, "unwritten elements");
+    for (idx_t t = 0; t < TIME_DIM_SIZE; t++)
+        for (idx_t i = -px; i < dx + px; i++)
+            for (idx_t j = -py; j < dy + py; j++)
+                for (idx_t k = -pz; k < dz + pz; k++)
+                    if (g.readElem((t + TIME_DIM_SIZE) * CPTS_T, i, j, k, __LINE__) !=
+                        val(t, i, j, k))
+                        checkFailed(what + " readElem", idxStr(t, i, j, k));
+}
+
+template <typename LayoutFn>
+void checkRealVecGridTNXYZ(const string& name, idx_t d) {
+    ostringstream msgs;
+    const idx_t dn = 3;
+    RealVecGrid_TNXYZ<LayoutFn> g(dn, d, d + 1, d + 2, 0, 1, 2, 3, name, msgs);
+    idx_t dx = g.get_dx(), dy = g.get_dy(), dz = g.get_dz();
+    idx_t px = g.get_px(), py = g.get_py(), pz = g.get_pz();
+    string what = "RealVecGrid_TNXYZ<" + name + ">";
+    g.set_same(-1);
+
+    auto val = [&](idx_t t, idx_t n, idx_t i, idx_t j, idx_t k) {
+        return real_t(((((t * dn + n) * (dx + 2 * px) + i + px) *
+                        (dy + 2 * py)) + j + py) * (dz + 2 * pz) + k + pz);
+    };
+    for (idx_t t = 0; t < TIME_DIM_SIZE; t++)
+        for (idx_t n = 0; n < dn; n++)
+            for (idx_t i = -px; i < dx + px; i++)
+                for (idx_t j = -py; j < dy + py; j++)
+                    for (idx_t k = -pz; k < dz + pz; k++)
+                        g.writeElem(val(t, n, i, j, k), t * CPTS_T, n, i, j, k, __LINE__);
+    if (countSame(g, -1))
+        checkFailed(what, "unwritten elements");
+    for (idx_t t = 0; t < TIME_DIM_SIZE; t++)
+        for (idx_t n = 0; n < dn; n++)
+            for (idx_t i = -px; i < dx + px; i++)
+                for (idx_t j = -py; j < dy + py; j++)
+                    for (idx_t k = -pz; k < dz + pz; k++)
+                        if (g.readElem((t + TIME_DIM_SIZE) * CPTS_T, n, i, j, k, __LINE__) !=
+                            val(t, n, i, j, k))
+                            checkFailed(what + " readElem", idxStr(t, n, i, j, k));
+}
+
+////// Benchmarks.
+// Each one copies one grid to another w/the same layout and returns
+// the best GB/s over 'ntrials' trials, counting the bytes read and
+// written. The 'zInner' loop order has the last index innermost,
+// like the stencil block loops; the other order has the first
+// spatial index (x) innermost.
+
+// Run 'copy' 'ntrials' times and return the best GB/s.
+template <typename CopyFn>
+double timeCopy(CopyFn copy, idx_t nbytes, int ntrials) {
+    double best = 0.;
+    for (int trial = 0; trial < ntrials; trial++) {
+        double start = getTimeInSecs();
+        copy();
+        double secs = getTimeInSecs() - start;
+        double gbps = 2. * nbytes / secs * 1e-9;
+        if (gbps > best)
+            best = gbps;
+    }
+    return best;
+}
+
+template <typename LayoutFn>
+void benchGrid3d(const string& name, idx_t d, int ntrials, double& zrate, double& xrate) {
+    GenericGrid3d<real_t, LayoutFn> a(d, d, d), b(d, d, d);
+    a.set_diff(1.0);
+    b.set_same(0.0);
+    zrate = timeCopy([&]() {
+#pragma omp parallel for
+            for (idx_t i = 0; i < d; i++)
+                for (idx_t j = 0; j < d; j++)
+                    for (idx_t k = 0; k < d; k++)
+                        b(i, j, k, false) = a(i, j, k, false);
+        }, a.get_num_bytes(), ntrials);
+    xrate = timeCopy([&]() {
+#pragma omp parallel for
+            for (idx_t k = 0; k < d; k++)
+                for (idx_t j = 0; j < d; j++)
+                    for (idx_t i = 0; i < d; i++)
+                        b(i, j, k, false) = a(i, j, k, false);
+        }, a.get_num_bytes(), ntrials);
+}
+
+template <typename LayoutFn>
+void benchGrid4d(const string& name, idx_t dn, idx_t d, int ntrials, double& zrate, double& xrate) {
+    GenericGrid4d<real_t, LayoutFn> a(dn, d, d, d), b(dn, d, d, d);
+    a.set_diff(1.0);
+    b.set_same(0.0);
+    zrate = timeCopy([&]() {
+            for (idx_t n = 0; n < dn; n++)
+#pragma omp parallel for
+                for (idx_t i = 0; i < d; i++)
+                    for (idx_t j = 0; j < d; j++)
+                        for (idx_t k = 0; k < d; k++)
+                            b(n, i, j, k, false) = a(n, i, j, k, false);
+        }, a.get_num_bytes(), ntrials);
+    xrate = timeCopy([&]() {
+            for (idx_t n = 0; n < dn; n++)
+#pragma omp parallel for
+                for (idx_t k = 0; k < d; k++)
+                    for (idx_t j = 0; j < d; j++)
+                        for (idx_t i = 0; i < d; i++)
+                            b(n, i, j, k, false) = a(n, i, j, k, false);
+        }, a.get_num_bytes(), ntrials);
+}
+
+// Copy time-step 0 to 1 by vectors, like a stencil update.
+template <typename LayoutFn>
+void benchRealVecGridTXYZ(const string& name, idx_t d, int ntrials, double& zrate, double& xrate) {
+    ostringstream msgs;
+    RealVecGrid_TXYZ<LayoutFn> g(d, d, d, 0, 0, 0, name, msgs);
+    g.set_diff(1.0);
+    idx_t dxv = g.get_dx() / VLEN_X, dyv = g.get_dy() / VLEN_Y, dzv = g.get_dz() / VLEN_Z;
+    idx_t t1 = CPTS_T % (TIME_DIM_SIZE * CPTS_T); // same as 0 if TIME_DIM_SIZE == 1.
+    idx_t nbytes = dxv * dyv * dzv * sizeof(real_vec_t);
+    zrate = timeCopy([&]() {
+#pragma omp parallel for
+            for (idx_t iv = 0; iv < dxv; iv++)
+                for (idx_t jv = 0; jv < dyv; jv++)
+                    for (idx_t kv = 0; kv < dzv; kv++)
+                        g.writeVecNorm(g.readVecNorm(0, iv, jv, kv, __LINE__),
+                                       t1, iv, jv, kv, __LINE__);
+        }, nbytes, ntrials);
+    xrate = timeCopy([&]() {
+#pragma omp parallel for
+            for (idx_t kv = 0; kv < dzv; kv++)
+                for (idx_t jv = 0; jv < dyv; jv++)
+                    for (idx_t iv = 0; iv < dxv; iv++)
+                        g.writeVecNorm(g.readVecNorm(0, iv, jv, kv, __LINE__),
+                                       t1, iv, jv, kv, __LINE__);
+        }, nbytes, ntrials);
+}
+
+template <typename LayoutFn>
+void benchRealVecGridXYZ(const string& name, idx_t d, int ntrials, double& zrate, double& xrate) {
+    ostringstream msgs;
+    RealVecGrid_XYZ<LayoutFn> a(d, d, d, 0, 0, 0, name, msgs), b(d, d, d, 0, 0, 0, name, msgs);
+    a.set_diff(1.0);
+    b.set_same(0.0);
+    idx_t dxv = a.get_dx() / VLEN_X, dyv = a.get_dy() / VLEN_Y, dzv = a.get_dz() / VLEN_Z;
+    zrate = timeCopy([&]() {
+#pragma omp parallel for
+            for (idx_t iv = 0; iv < dxv; iv++)
+                for (idx_t jv = 0; jv < dyv; jv++)
+                    for (idx_t kv = 0; kv < dzv; kv++)
+                        b.writeVecNorm(a.readVecNorm(iv, jv, kv, __LINE__),
+                                       iv, jv, kv, __LINE__);
+        }, a.get_num_bytes(), ntrials);
+    xrate = timeCopy([&]() {
+#pragma omp parallel for
+            for (idx_t kv = 0; kv < dzv; kv++)
+                for (idx_t jv = 0; jv < dyv; jv++)
+                    for (idx_t iv = 0; iv < dxv; iv++)
+                        b.writeVecNorm(a.readVecNorm(iv, jv, kv, __LINE__),
+                                       iv, jv, kv, __LINE__);
+        }, a.get_num_bytes(), ntrials);
+}
+
+// Print one line of benchmark results.
+void printRates(const string& name, double zrate, double xrate) {
+    cout << "  " << left << setw(14) << name << right << fixed << setprecision(2) <<
+        setw(12) << zrate << setw(12) << xrate << endl;
+}
+void printRatesHeader(const string& what) {
+    cout << endl << what << " copy throughput (GB/s):" << endl <<
+        "  " << left << setw(14) << "layout" << right <<
+        setw(12) << "z-inner" << setw(12) << "x-inner" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    // options and their defaults.
+    idx_t d = 128;              // size of each spatial dim in benchmarks.
+    idx_t dn = 4;               // size of 'n' dim in 4D benchmarks.
+    int num_trials = 3;         // number of trials; best is reported.
+    bool doBench = true;
+
+    // parse options.
+    for (int argi = 1; argi < argc; argi++) {
+        if ( argv[argi][0] == '-' && argv[argi][1] ) {
+            string opt = argv[argi];
+
+            // options w/o values.
+            if (opt == "-h" || opt == "-help" || opt == "--help") {
+                cout << 
+                    "Usage: [options]\n"
+                    "Options:\n"
+                    " -h:              print this help and exit\n"
+                    " -nb              skip benchmarks; only run correctness checks\n"
+                    " -t <n>           number of benchmark trials; the fastest is reported, default=" <<
+                    num_trials << endl <<
+                    " -d <n>           benchmark grid size in each spatial dimension, default=" <<
+                    d << endl <<
+                    " -dn <n>          benchmark grid size in 'n' dimension of 4D grids, default=" <<
+                    dn << endl <<
+                    "Notes:\n"
+                    " 3D dims are 1=x, 2=y, 3=z; 4D dims are 1=n/t, 2=x, 3=y, 4=z.\n"
+                    " The last number in a layout name has unit stride.\n"
+                    " Current build uses layout_3d=" << STR(LAYOUT_3D) <<
+                    " and layout_4d=" << STR(LAYOUT_4D) << ".\n";
+                exit(0);
+            }
+            else if (opt == "-nb")
+                doBench = false;
+
+            // options w/int values.
+            else {
+
+                if (argi + 1 >= argc) {
+                    cerr << "error: no value for option '" << opt << "'." << endl;
+                    exit(1);
+                }
+                int val = atoi(argv[++argi]);
+                if (opt == "-t") num_trials = val;
+                else if (opt == "-d") d = val;
+                else if (opt == "-dn") dn = val;
+                else {
+                    cerr << "error: option '" << opt << "' not recognized." << endl;
+                    exit(1);
+                }
+            }
+        }
+        else {
+            cerr << "error: extraneous parameter '" <<
+                argv[argi] << "'." << endl;
+            exit(1);
+        }
+    }
+
+    // Correctness checks.
+    // Use small, unequal, odd sizes to catch mixed-up dimensions.
+    cout << "Checking layouts..." << endl;
+#define CHECK1(L) checkGrid1d<L>(#L, 7);
+#define CHECK2(L) checkGrid2d<L>(#L, 5, 7);
+#define CHECK3(L) checkGrid3d<L>(#L, 3, 5, 7); checkRealVecGridXYZ<L>(#L, 3);
+#define CHECK4(L) checkGrid4d<L>(#L, 2, 3, 5, 7); checkRealVecGridNXYZ<L>(#L, 3); \
+    checkRealVecGridTXYZ<L>(#L, 3); checkRealVecGridTNXYZ<L>(#L, 3);
+    LAYOUTS_1D(CHECK1)
+    LAYOUTS_2D(CHECK2)
+    LAYOUTS_3D(CHECK3)
+    LAYOUTS_4D(CHECK4)
+
+    // Benchmarks.
+    if (doBench) {
+        double zrate, xrate;
+        cout << endl << "Benchmark sizes: " << dn << '*' << d << '*' << d << '*' << d <<
+            ", " << REAL_BYTES << "-byte reals, VLEN=" << VLEN <<
+            ", " << omp_get_max_threads() << " thread(s)" << endl;
+#define BENCH3(L) benchGrid3d<L>(#L, d, num_trials, zrate, xrate); printRates(#L, zrate, xrate);
+#define BENCH4(L) benchGrid4d<L>(#L, dn, d, num_trials, zrate, xrate); printRates(#L, zrate, xrate);
+#define BENCHV3(L) benchRealVecGridXYZ<L>(#L, d, num_trials, zrate, xrate); printRates(#L, zrate, xrate);
+#define BENCHV4(L) benchRealVecGridTXYZ<L>(#L, d, num_trials, zrate, xrate); printRates(#L, zrate, xrate);
+        printRatesHeader("GenericGrid3d");
+        LAYOUTS_3D(BENCH3)
+        printRatesHeader("GenericGrid4d");
+        LAYOUTS_4D(BENCH4)
+        printRatesHeader("RealVecGrid_XYZ");
+        LAYOUTS_3D(BENCHV3)
+        printRatesHeader("RealVecGrid_TXYZ");
+        LAYOUTS_4D(BENCHV4)
+    }
+
+    cout << endl;
+    if (num_errs == 0)
+        cout << "TEST PASSED." << endl;
+    else {
+        cerr << "TEST FAILED: " << num_errs << " mismatch(es)." << endl;
+        exit(1);
+    }
+    return 0;
+}
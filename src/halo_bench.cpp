@@ -0,0 +1,391 @@
+/*****************************************************************************
+
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2016, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+// Halo-exchange microbenchmark.
+// Builds the stencil context for a given rank decomposition and calls
+// only StencilBase::exchange_halos() repeatedly. Packing, waiting, and
+// unpacking are timed for each neighbor direction using the context's
+// halo_stats. Then, the packed buffers are sent to each neighbor
+// direction in turn without packing to measure the message rate and the
+// bandwidth of the MPI transport alone.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <iomanip>
+#include <sstream>
+
+// Stencil types.
+#include "stencil.hpp"
+
+// Base classes for stencil code.
+#include "stencil_calc.hpp"
+
+// Include auto-generated stencil code.
+#include "stencil_code.hpp"
+
+using namespace std;
+using namespace yask;
+
+// Values summed over ranks for each neighbor direction.
+enum DirVal {
+    dv_ranks,                   // ranks w/a neighbor in this direction.
+    dv_pack_secs, dv_pack_bytes,
+    dv_unpack_secs, dv_unpack_bytes,
+    dv_wire_secs, dv_wire_bytes, dv_wire_msgs,
+    num_dir_vals };
+
+// Name a neighbor direction from its 0..2 indices, e.g., "x+y-".
+string dirName(idx_t nn, idx_t nx, idx_t ny, idx_t nz) {
+    const char* signs = "- +";
+    string s;
+    if (nn != StencilContext::rank_self) { s += 'n'; s += signs[nn]; }
+    if (nx != StencilContext::rank_self) { s += 'x'; s += signs[nx]; }
+    if (ny != StencilContext::rank_self) { s += 'y'; s += signs[ny]; }
+    if (nz != StencilContext::rank_self) { s += 'z'; s += signs[nz]; }
+    return s;
+}
+
+// Rate in G per sec, or 0 if no time was measured.
+double gRate(double num, double secs) {
+    return (secs > 0.) ? num / secs * 1e-9 : 0.;
+}
+
+int main(int argc, char** argv)
+{
+#ifndef USE_MPI
+    cerr << "error: the halo benchmark requires MPI; rebuild with mpi=1." << endl;
+    exit(1);
+#else
+    MPI_Init(&argc, &argv);
+    MPI_Comm comm = MPI_COMM_WORLD;
+    int my_rank = 0;
+    int num_ranks = 1;
+    MPI_Comm_rank(comm, &my_rank);
+    MPI_Comm_size(comm, &num_ranks);
+    bool is_leader = my_rank == 0;
+
+    // options and their defaults.
+    idx_t dn = 1, dx = 128, dy = 128, dz = 128; // rank size.
+    idx_t nrn = 1, nrx = num_ranks, nry = 1, nrz = 1; // num ranks in each dim.
+    int num_iters = 100;        // timed exchanges.
+    int num_warmups = 10;       // untimed exchanges.
+
+    // parse options.
+    bool help = false;
+    for (int argi = 1; argi < argc; argi++) {
+        if ( argv[argi][0] == '-' && argv[argi][1] ) {
+            string opt = argv[argi];
+
+            // options w/o values.
+            if (opt == "-h" || opt == "-help" || opt == "--help") {
+                if (is_leader)
+                    cout << 
+                        "Usage: [options]\n"
+                        "Options:\n"
+                        " -h:              print this help and exit\n"
+                        " -d{n,x,y,z} <n>  rank domain size in specified spatial dimension, defaults=" <<
+                        dn << '*' << dx << '*' << dy << '*' << dz << endl <<
+                        " -d <n>           set same rank size in 3 {x,y,z} spatial dimensions\n" <<
+                        " -nr{n,x,y,z} <n> num ranks in specified spatial dimension, defaults=" <<
+                        nrn << '*' << nrx << '*' << nry << '*' << nrz << endl <<
+                        " -nr <n>          set same num ranks in 3 {x,y,z} spatial dimensions\n" <<
+                        " -i <n>           number of timed exchanges, default=" <<
+                        num_iters << endl <<
+                        " -w <n>           number of untimed warmup exchanges, default=" <<
+                        num_warmups << endl <<
+                        "Notes:\n"
+                        " Halo sizes are those required by the '" STENCIL_NAME "' stencil.\n"
+                        " Pack and unpack rates are bytes in buffers per second of copying.\n"
+                        " Wire rates are measured by sending to one direction at a time\n"
+                        "  w/o packing; they are per rank, averaged over the ranks\n"
+                        "  that have a neighbor in that direction.\n"
+                        "Examples:\n" <<
+                        " mpirun -np 2 " << argv[0] << " -d 256\n" <<
+                        " mpirun -np 8 " << argv[0] << " -nrx 2 -nry 2 -nrz 2\n";
+                help = true;
+            }
+
+            // options w/int values.
+            else {
+
+                if (argi + 1 >= argc) {
+                    cerr << "error: no value for option '" << opt << "'." << endl;
+                    exit(1);
+                }
+                int val = atoi(argv[++argi]);
+                if (opt == "-i") num_iters = val;
+                else if (opt == "-w") num_warmups = val;
+                else if (opt == "-dn") dn = val;
+                else if (opt == "-dx") dx = val;
+                else if (opt == "-dy") dy = val;
+                else if (opt == "-dz") dz = val;
+                else if (opt == "-d") dx = dy = dz = val;
+                else if (opt == "-nrn") nrn = val;
+                else if (opt == "-nrx") nrx = val;
+                else if (opt == "-nry") nry = val;
+                else if (opt == "-nrz") nrz = val;
+                else if (opt == "-nr") nrx = nry = nrz = val;
+                else {
+                    cerr << "error: option '" << opt << "' not recognized." << endl;
+                    exit(1);
+                }
+            }
+        }
+        else {
+            cerr << "error: extraneous parameter '" <<
+                argv[argi] << "'." << endl;
+            exit(1);
+        }
+    }
+    if (help) {
+        MPI_Finalize();
+        return 0;
+    }
+
+#ifndef USING_DIM_N
+    if (dn > 1) {
+        cerr << "error: dn = " << dn << ", but stencil '"
+            STENCIL_NAME "' doesn't use dimension 'n'." << endl;
+        exit(1);
+    }
+#endif
+    if (num_iters < 1) {
+        cerr << "error: number of exchanges must be positive." << endl;
+        exit(1);
+    }
+
+    // Check ranks.
+    idx_t req_ranks = nrn * nrx * nry * nrz;
+    if (req_ranks != num_ranks) {
+        cerr << "error: " << req_ranks << " rank(s) requested, but MPI reports " <<
+            num_ranks << " rank(s) are active." << endl;
+        exit(1);
+    }
+
+    // Context w/o any region or block tiling.
+    // Grid messages go to a string so ranks don't interleave them.
+    STENCIL_CONTEXT context;
+    context.num_ranks = num_ranks;
+    context.my_rank = my_rank;
+    context.comm = comm;
+    context.orig_max_threads = omp_get_max_threads();
+    context.dt = CPTS_T;
+    context.dn = context.rn = context.bn = ROUND_UP(dn, CPTS_N);
+    context.dx = context.rx = context.bx = ROUND_UP(dx, VLEN_X);
+    context.dy = context.ry = context.by = ROUND_UP(dy, VLEN_Y);
+    context.dz = context.rz = context.bz = ROUND_UP(dz, VLEN_Z);
+    context.rt = context.bt = 1;
+    context.pn = 0;
+    context.px = ROUND_UP(DEF_PAD, VLEN_X);
+    context.py = ROUND_UP(DEF_PAD, VLEN_Y);
+    context.pz = ROUND_UP(DEF_PAD, VLEN_Z);
+#ifdef USING_DIM_N
+    context.hn = ROUND_UP(context.max_halo_n, VLEN_N);
+#else
+    context.hn = 0;
+#endif
+    context.hx = ROUND_UP(context.max_halo_x, VLEN_X);
+    context.hy = ROUND_UP(context.max_halo_y, VLEN_Y);
+    context.hz = ROUND_UP(context.max_halo_z, VLEN_Z);
+    context.nrn = nrn;
+    context.nrx = nrx;
+    context.nry = nry;
+    context.nrz = nrz;
+
+    // Setup messages go to std::cout; only show the leader's.
+    streambuf* coutbuf = cout.rdbuf();
+    ostringstream setup_msgs;
+    if (!is_leader)
+        cout.rdbuf(setup_msgs.rdbuf());
+    if (is_leader)
+        cout << "Halo-exchange benchmark for the '" STENCIL_NAME "' stencil" << endl <<
+            " num-ranks: " << nrn << '*' << nrx << '*' << nry << '*' << nrz << endl <<
+            " rank-size: " << context.dn << '*' << context.dx << '*' <<
+            context.dy << '*' << context.dz << endl <<
+            " vector-size: " << VLEN_N << '*' << VLEN_X << '*' << VLEN_Y << '*' << VLEN_Z << endl <<
+            " halos: " << context.hn << '+' << context.hx << '+' <<
+            context.hy << '+' << context.hz << endl <<
+            " real-bytes: " << REAL_BYTES << endl <<
+            " num-threads: " << context.orig_max_threads << endl << endl;
+    context.allocGrids();
+    context.allocParams();
+    context.setupMPI();
+    context.initSame();
+    STENCIL_EQUATIONS stencils;
+    stencils.init(context);
+    cout.rdbuf(coutbuf);
+
+    // Exchange halos for all stencil equations once.
+    auto exchangeAll = [&]() {
+        for (auto stencil : stencils.stencils)
+            stencil->exchange_halos(context, 0, CPTS_T);
+    };
+
+    // Full exchanges.
+    for (int i = 0; i < num_warmups; i++)
+        exchangeAll();
+    StencilContext::HaloStats stats;
+    MPI_Barrier(comm);
+    context.halo_stats = &stats;
+    double xstart = getTimeInSecs();
+    for (int i = 0; i < num_iters; i++)
+        exchangeAll();
+    double xsecs = getTimeInSecs() - xstart;
+    context.halo_stats = 0;
+    MPI_Barrier(comm);
+
+    // Values to be summed over ranks, by direction.
+    const int num_neighbors = StencilContext::num_neighbors;
+    vector<double> dir_vals(context.neighborhood_size * num_dir_vals, 0.);
+    auto dirVal = [&](idx_t nn, idx_t nx, idx_t ny, idx_t nz, int dv) -> double& {
+        idx_t di = ((nn * num_neighbors + nx) * num_neighbors + ny) * num_neighbors + nz;
+        return dir_vals[di * num_dir_vals + dv];
+    };
+
+    // Wire-only exchanges.
+    // For each direction d, every rank sends its packed buffers to its
+    // neighbor at d and receives from its neighbor at -d. All ranks
+    // visit the directions in the same order.
+    for (idx_t nn = 0; nn < num_neighbors; nn++)
+        for (idx_t nx = 0; nx < num_neighbors; nx++)
+            for (idx_t ny = 0; ny < num_neighbors; ny++)
+                for (idx_t nz = 0; nz < num_neighbors; nz++) {
+                    auto& ds = stats.dirs[nn][nx][ny][nz];
+                    int to_rank = context.my_neighbors[nn][nx][ny][nz];
+                    int from_rank = context.my_neighbors[2-nn][2-nx][2-ny][2-nz];
+                    if (to_rank != MPI_PROC_NULL) {
+                        dirVal(nn, nx, ny, nz, dv_ranks) = 1.;
+                        dirVal(nn, nx, ny, nz, dv_pack_secs) = ds.pack_secs;
+                        dirVal(nn, nx, ny, nz, dv_pack_bytes) = ds.pack_bytes;
+                        dirVal(nn, nx, ny, nz, dv_unpack_secs) = ds.unpack_secs;
+                        dirVal(nn, nx, ny, nz, dv_unpack_bytes) = ds.unpack_bytes;
+                    }
+
+                    // Post sends & receives for all buffers; return bytes sent
+                    // and add the number of messages sent to nmsgs.
+                    vector<MPI_Request> reqs;
+                    auto sendAll = [&](idx_t& nmsgs) {
+                        idx_t nbytes = 0;
+                        reqs.clear();
+                        for (size_t gi = 0; gi < context.eqGridPtrs.size(); gi++) {
+                            auto& gbufs = context.bufs[context.eqGridPtrs[gi]];
+                            auto sendBuf = gbufs(StencilContext::Bufs::bufSend, nn, nx, ny, nz);
+                            auto rcvBuf = gbufs(StencilContext::Bufs::bufRec, 2-nn, 2-nx, 2-ny, 2-nz);
+                            if (to_rank != MPI_PROC_NULL && sendBuf) {
+                                reqs.push_back(MPI_Request());
+                                MPI_Isend(sendBuf->getRawData(), sendBuf->get_num_bytes(), MPI_BYTE,
+                                          to_rank, int(gi), comm, &reqs.back());
+                                nbytes += sendBuf->get_num_bytes();
+                                nmsgs++;
+                            }
+                            if (from_rank != MPI_PROC_NULL && rcvBuf) {
+                                reqs.push_back(MPI_Request());
+                                MPI_Irecv(rcvBuf->getRawData(), rcvBuf->get_num_bytes(), MPI_BYTE,
+                                          from_rank, int(gi), comm, &reqs.back());
+                            }
+                        }
+                        MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+                        return nbytes;
+                    };
+                    MPI_Barrier(comm);
+                    idx_t wire_bytes = 0, wire_msgs = 0;
+                    for (int i = 0; i < num_warmups; i++)
+                        sendAll(wire_msgs);
+                    MPI_Barrier(comm);
+                    wire_msgs = 0;
+                    double wstart = getTimeInSecs();
+                    for (int i = 0; i < num_iters; i++)
+                        wire_bytes += sendAll(wire_msgs);
+                    double wsecs = getTimeInSecs() - wstart;
+                    if (to_rank != MPI_PROC_NULL) {
+                        dirVal(nn, nx, ny, nz, dv_wire_secs) = wsecs;
+                        dirVal(nn, nx, ny, nz, dv_wire_bytes) = wire_bytes;
+                        dirVal(nn, nx, ny, nz, dv_wire_msgs) = wire_msgs;
+                    }
+                }
+
+    // Sum over ranks.
+    vector<double> sum_vals(dir_vals.size(), 0.);
+    MPI_Reduce(dir_vals.data(), sum_vals.data(), dir_vals.size(), MPI_DOUBLE,
+               MPI_SUM, 0, comm);
+    double tot_vals[] = { xsecs, stats.wait_secs };
+    double sum_tot_vals[2];
+    MPI_Reduce(tot_vals, sum_tot_vals, 2, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+    if (is_leader) {
+        double tot_pack_secs = 0., tot_unpack_secs = 0.;
+        for (idx_t di = 0; di < context.neighborhood_size; di++) {
+            tot_pack_secs += sum_vals[di * num_dir_vals + dv_pack_secs];
+            tot_unpack_secs += sum_vals[di * num_dir_vals + dv_unpack_secs];
+        }
+
+        // Average per-rank time of one exchange of all grids.
+        double n = double(num_iters) * num_ranks;
+        double x_usec = sum_tot_vals[0] / n * 1e6;
+        double pack_usec = tot_pack_secs / n * 1e6;
+        double wait_usec = sum_tot_vals[1] / n * 1e6;
+        double unpack_usec = tot_unpack_secs / n * 1e6;
+        cout << fixed << setprecision(2) <<
+            "Time per exchange of all " << context.eqGridPtrs.size() <<
+            " grid(s), averaged over " << num_iters << " exchange(s) and " <<
+            num_ranks << " rank(s) (usec):" << endl <<
+            " total: " << x_usec << endl <<
+            " pack: " << pack_usec << endl <<
+            " wait: " << wait_usec << endl <<
+            " unpack: " << unpack_usec << endl <<
+            " other: " << (x_usec - pack_usec - wait_usec - unpack_usec) << endl;
+
+        // Per-direction table.
+        cout << endl << "Rates by neighbor direction:" << endl <<
+            left << setw(10) << "direction" << right <<
+            setw(7) << "ranks" << setw(14) << "msg-bytes" <<
+            setw(12) << "pack-GB/s" << setw(13) << "unpack-GB/s" <<
+            setw(12) << "msgs/sec" << setw(12) << "wire-GB/s" << endl;
+        for (idx_t nn = 0; nn < num_neighbors; nn++)
+            for (idx_t nx = 0; nx < num_neighbors; nx++)
+                for (idx_t ny = 0; ny < num_neighbors; ny++)
+                    for (idx_t nz = 0; nz < num_neighbors; nz++) {
+                        idx_t di = ((nn * num_neighbors + nx) * num_neighbors + ny) *
+                            num_neighbors + nz;
+                        double* v = &sum_vals[di * num_dir_vals];
+                        if (v[dv_ranks] == 0.)
+                            continue;
+                        double msg_bytes = v[dv_wire_msgs] ? v[dv_wire_bytes] / v[dv_wire_msgs] : 0.;
+                        cout << left << setw(10) << dirName(nn, nx, ny, nz) << right <<
+                            setw(7) << idx_t(v[dv_ranks]) <<
+                            setw(14) << idx_t(msg_bytes) << setprecision(2) <<
+                            setw(12) << gRate(v[dv_pack_bytes], v[dv_pack_secs]) <<
+                            setw(13) << gRate(v[dv_unpack_bytes], v[dv_unpack_secs]) <<
+                            setprecision(0) <<
+                            setw(12) << (v[dv_wire_secs] > 0. ? v[dv_wire_msgs] / v[dv_wire_secs] : 0.) <<
+                            setprecision(2) <<
+                            setw(12) << gRate(v[dv_wire_bytes], v[dv_wire_secs]) << endl;
+                    }
+    }
+
+    MPI_Finalize();
+    return 0;
+#endif
+}
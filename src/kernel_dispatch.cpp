@@ -0,0 +1,272 @@
+/*****************************************************************************
+
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2016, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+// Run-time selection among kernel variants.
+// When built with 'variants' set (see Makefile), the kernels are
+// compiled once for each variant, i.e., each combination of arch,
+// vector fold, and cluster, each in its own namespace and with its own
+// main() renamed to stencil_main_<tag>(). This main() selects one of
+// them and calls it.
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#ifdef USE_MPI
+#include "mpi.h"
+#endif
+
+using namespace std;
+
+// Entry points.
+#define KERNEL_VARIANT(tag, arch, fold, cluster)        \
+    int stencil_main_ ## tag(int argc, char** argv);
+#include "kernel_variants.hpp"
+#undef KERNEL_VARIANT
+
+// Descriptions of the variants in the order they were built.
+struct KernelVariant {
+    const char* arch;
+    const char* fold;
+    const char* cluster;
+    int (*stencil_main)(int argc, char** argv);
+};
+#define KERNEL_VARIANT(tag, arch, fold, cluster)        \
+    { arch, fold, cluster, stencil_main_ ## tag },
+KernelVariant kernel_variants[] = {
+#include "kernel_variants.hpp"
+};
+#undef KERNEL_VARIANT
+const int num_kernel_variants = sizeof(kernel_variants) / sizeof(kernel_variants[0]);
+
+// Exit after an error. MPI is started in the kernel, so it may not be
+// running yet; with MPI, all ranks are stopped so that none of them
+// waits for this one.
+void fail() {
+#ifdef USE_MPI
+    int inited = 0;
+    MPI_Initialized(&inited);
+    if (!inited)
+        MPI_Init(NULL, NULL);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
+    exit(1);
+}
+
+// Name of a variant for messages.
+string variantName(const KernelVariant& kv) {
+    return string("arch=") + kv.arch + " fold=" + kv.fold + " cluster=" + kv.cluster;
+}
+
+// Return a rank for the given arch: higher is more capable.
+// Return -1 if the CPU does not support it.
+int archRank(const string& arch) {
+#define CPU(feature) __builtin_cpu_supports(feature)
+    if (arch == "skx")
+        return (CPU("avx512f") && CPU("avx512cd") && CPU("avx512bw") &&
+                CPU("avx512dq") && CPU("avx512vl")) ? 3 : -1;
+    if (arch == "knl")
+        return (CPU("avx512f") && CPU("avx512cd") &&
+                CPU("avx512er") && CPU("avx512pf")) ? 3 : -1;
+    if (arch == "hsw")
+        return (CPU("avx2") && CPU("fma")) ? 2 : -1;
+    if (arch == "ivb" || arch == "snb")
+        return CPU("avx") ? 1 : -1;
+    if (arch == "intel64")
+        return 0;
+#undef CPU
+    return -1;
+}
+
+// Convert a number printed by printWithPow10Multiplier() to a value.
+double getVal(const string& str) {
+    istringstream iss(str);
+    double val = 0.;
+    char mult = 0;
+    iss >> val >> mult;
+    return val * (mult == 'K' ? 1e3 : mult == 'M' ? 1e6 : mult == 'G' ? 1e9 : 1.);
+}
+
+// Run one trial of a variant in a child process and return its
+// throughput in points/sec, or 0 if it failed.
+double measureVariant(const KernelVariant& kv, vector<char*> args) {
+    static char topt[] = "-t", tval[] = "1";
+    args.pop_back();            // remove terminating null.
+    args.push_back(topt);
+    args.push_back(tval);
+    int nargs = int(args.size());
+    args.push_back(0);
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        cerr << "error: cannot create pipe." << endl;
+        fail();
+    }
+    cout << flush;
+    pid_t pid = fork();
+    if (pid < 0) {
+        cerr << "error: cannot create process." << endl;
+        fail();
+    }
+
+    // Child: run the kernel w/its output to the pipe.
+    if (pid == 0) {
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        close(fds[1]);
+        int ret = kv.stencil_main(nargs, args.data());
+        cout << flush;
+        _exit(ret);
+    }
+
+    // Parent: find the throughput in the output.
+    close(fds[1]);
+    const string key = "best-throughput (points/sec):";
+    string out;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+        out.append(buf, n);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return 0.;
+    size_t pos = out.rfind(key);
+    return (pos == string::npos) ? 0. : getVal(out.substr(pos + key.length()));
+}
+
+int main(int argc, char** argv)
+{
+    __builtin_cpu_init();
+
+    // Remove the options for this function from the args passed to the kernel.
+    string req_arch, req_fold, req_cluster;
+    bool tune = false, help = false;
+    vector<char*> args;
+    for (int argi = 0; argi < argc; argi++) {
+        string opt = argv[argi];
+        if (opt == "-arch" || opt == "-fold" || opt == "-cluster") {
+            if (argi + 1 >= argc) {
+                cerr << "error: no value for option '" << opt << "'." << endl;
+                fail();
+            }
+            string val = argv[++argi];
+            if (opt == "-arch") req_arch = val;
+            else if (opt == "-fold") req_fold = val;
+            else req_cluster = val;
+        }
+        else if (opt == "-tune_variants")
+            tune = true;
+        else {
+            if (opt == "-h" || opt == "-help" || opt == "--help")
+                help = true;
+            args.push_back(argv[argi]);
+        }
+    }
+    int nargs = int(args.size());
+    args.push_back(0);
+
+    if (help) {
+        cout << "Kernel variants in this executable:\n";
+        for (int i = 0; i < num_kernel_variants; i++)
+            cout << " " << variantName(kernel_variants[i]) <<
+                (archRank(kernel_variants[i].arch) < 0 ? " (not supported by this CPU)" : "") << endl;
+        cout << "Variant-selection options:\n"
+            " -arch <name>     use a variant built for the given arch\n"
+            " -fold <fold>     use a variant built w/the given fold, e.g., 'x=4,y=4,z=1'\n"
+            " -cluster <clus>  use a variant built w/the given cluster, e.g., 'x=1,y=1,z=2'\n"
+            " -tune_variants   run one trial of each matching variant and use the fastest\n"
+            "Without -tune_variants, the first matching variant for the most capable arch\n"
+            " supported by this CPU is used.\n\n";
+    }
+
+    // Find the matching variants.
+    // Ones for unsupported archs are only considered if the arch is requested.
+    vector<int> matches;
+    int best_rank = -1;
+    for (int i = 0; i < num_kernel_variants; i++) {
+        auto& kv = kernel_variants[i];
+        if ((req_arch.length() && req_arch != kv.arch) ||
+            (req_fold.length() && req_fold != kv.fold) ||
+            (req_cluster.length() && req_cluster != kv.cluster))
+            continue;
+        int rank = archRank(kv.arch);
+        if (rank < 0 && !req_arch.length())
+            continue;
+        if (rank > best_rank) {
+            best_rank = rank;
+            matches.clear();
+        }
+        if (rank == best_rank)
+            matches.push_back(i);
+    }
+    if (!matches.size()) {
+        cerr << "error: no kernel variant in this executable matches the requested options "
+            "and is supported by this CPU; available:" << endl;
+        for (int i = 0; i < num_kernel_variants; i++)
+            cerr << " " << variantName(kernel_variants[i]) << endl;
+        fail();
+    }
+    int sel = matches[0];
+
+    // Select the fastest.
+    if (tune && matches.size() > 1 && !help) {
+#ifdef USE_MPI
+        cerr << "error: -tune_variants is not supported with MPI; select a variant with "
+            "-arch, -fold, and/or -cluster." << endl;
+        fail();
+#endif
+        cout << "Measuring " << matches.size() << " kernel variant(s)..." << endl;
+        double best_pps = 0.;
+        for (int i : matches) {
+            double pps = measureVariant(kernel_variants[i], args);
+            cout << " " << variantName(kernel_variants[i]) << ": ";
+            if (pps > 0.)
+                cout << (pps * 1e-6) << "M points/sec" << endl;
+            else
+                cout << "failed" << endl;
+            if (pps > best_pps) {
+                best_pps = pps;
+                sel = i;
+            }
+        }
+        if (best_pps <= 0.) {
+            cerr << "error: all kernel variants failed." << endl;
+            fail();
+        }
+    }
+
+    auto& kv = kernel_variants[sel];
+    if (archRank(kv.arch) < 0)
+        cerr << "warning: this CPU may not support arch '" << kv.arch << "'." << endl;
+    cout << "Using kernel variant " << variantName(kv) << "." << endl;
+    return kv.stencil_main(nargs, args.data());
+}
@@ -0,0 +1,5 @@
+// Automatically generated; do not edit.
+
+// Apply macro 'fn' to each pair of 3-D and 4-D layout classes
+// that may be selected at run-time.
+#define LAYOUT_CHOICES(fn) fn(Layout_123, Layout_1234)
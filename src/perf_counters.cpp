@@ -0,0 +1,253 @@
+/*****************************************************************************
+
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2016, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+#include "stencil.hpp"
+#include "stencil_calc.hpp"
+
+#ifdef USE_PERF_COUNTERS
+#include <mutex>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace yask {
+
+    vector<PerfCounters::Group> PerfCounters::_groups;
+    PerfCounters::GroupKind PerfCounters::_kind = PerfCounters::no_counters;
+    bool PerfCounters::_opened = false;
+    bool PerfCounters::_running = false;
+
+#ifdef USE_PERF_COUNTERS
+
+    // Protects _groups and _running.
+    static mutex pc_lock;
+
+    // Events in each group.
+    static const struct {
+        uint32_t type;
+        uint64_t config;
+        const char* name;
+    } pc_events[2][PerfCounters::num_counters] = {
+        { { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles" },
+          { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions" },
+          { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "LLC-misses" } },
+        { { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "task-clock" },
+          { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context-switches" },
+          { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "page-faults" } }
+    };
+
+    // Open a counter for the calling thread on any CPU.
+    static int perf_event_open(struct perf_event_attr* attr, int group_fd) {
+        return int(syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0));
+    }
+
+    bool PerfCounters::openGroup(GroupKind kind) {
+        Group grp;
+        for (int ci = 0; ci < num_counters; ci++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = pc_events[kind][ci].type;
+            attr.config = pc_events[kind][ci].config;
+            attr.disabled = (ci == 0) ? 1 : 0; // members follow the leader.
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            grp.fds[ci] = perf_event_open(&attr, (ci == 0) ? -1 : grp.fds[0]);
+            grp.vals[ci] = -1;
+
+            // Must have a leader.
+            if (ci == 0 && grp.fds[0] < 0)
+                return false;
+        }
+
+        // Start now if added during a trial.
+        if (_running)
+            ioctl(grp.fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        _groups.push_back(grp);
+        return true;
+    }
+
+    bool PerfCounters::addThread() {
+        lock_guard<mutex> lock(pc_lock);
+        if (!_opened)
+            return false;
+        if (_kind != no_counters)
+            openGroup(_kind);
+        return true;
+    }
+
+    void PerfCounters::open(StencilContext& context) {
+        {
+            lock_guard<mutex> lock(pc_lock);
+            if (_opened)
+                return;
+            _opened = true;
+
+            // Try HW counters first, then SW.
+            // The probe group is closed; it is reopened below.
+            for (int kind = hw_counters; kind < no_counters; kind++) {
+                if (openGroup(GroupKind(kind))) {
+                    _kind = GroupKind(kind);
+                    for (int ci = num_counters - 1; ci >= 0; ci--)
+                        if (_groups.back().fds[ci] >= 0)
+                            close(_groups.back().fds[ci]);
+                    _groups.pop_back();
+                    break;
+                }
+            }
+        }
+        if (_kind == no_counters)
+            return;
+
+        // Open counters for this thread and the threads used in the region
+        // and block loops now to keep the syscalls out of the first trial.
+        addThisThread();
+        context.set_region_threads();
+#pragma omp parallel
+        {
+            context.set_block_threads();
+#pragma omp parallel
+            addThisThread();
+        }
+        context.set_max_threads();
+    }
+
+    string PerfCounters::getName(int ci) {
+        if (_kind == no_counters)
+            return "none";
+        return pc_events[_kind][ci].name;
+    }
+
+    void PerfCounters::start() {
+        lock_guard<mutex> lock(pc_lock);
+        for (auto& grp : _groups) {
+            ioctl(grp.fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(grp.fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+        _running = true;
+    }
+
+    void PerfCounters::stop() {
+        lock_guard<mutex> lock(pc_lock);
+        for (auto& grp : _groups)
+            ioctl(grp.fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        _running = false;
+
+        for (auto& grp : _groups) {
+            for (int ci = 0; ci < num_counters; ci++) {
+                long long val = -1;
+                uint64_t buf[3]; // value, time enabled, time running.
+                if (grp.fds[ci] >= 0 &&
+                    read(grp.fds[ci], buf, sizeof(buf)) == sizeof(buf)) {
+
+                    // Scale if counter was multiplexed.
+                    if (buf[2] == 0)
+                        val = 0;
+                    else if (buf[2] < buf[1])
+                        val = (long long)(double(buf[0]) * double(buf[1]) / double(buf[2]));
+                    else
+                        val = (long long)buf[0];
+                }
+                grp.vals[ci] = val;
+            }
+        }
+    }
+
+#else
+
+    // Stubs.
+    bool PerfCounters::openGroup(GroupKind kind) { return false; }
+    bool PerfCounters::addThread() { return true; }
+    void PerfCounters::open(StencilContext& context) { }
+    string PerfCounters::getName(int ci) { return "none"; }
+    void PerfCounters::start() { }
+    void PerfCounters::stop() { }
+
+#endif
+
+    long long PerfCounters::getSum(int ci) {
+        long long sum = 0;
+        for (auto& grp : _groups) {
+            if (grp.vals[ci] < 0)
+                return -1;
+            sum += grp.vals[ci];
+        }
+        return _groups.size() ? sum : -1;
+    }
+
+    // Threads that did not run, e.g., ones that have exited,
+    // are ignored.
+    long long PerfCounters::getMin(int ci) {
+        long long res = -1;
+        for (auto& grp : _groups)
+            if (grp.vals[pc_0] > 0 && (res < 0 || grp.vals[ci] < res))
+                res = grp.vals[ci];
+        return res;
+    }
+    long long PerfCounters::getMax(int ci) {
+        long long res = -1;
+        for (auto& grp : _groups)
+            if (grp.vals[pc_0] > 0 && grp.vals[ci] > res)
+                res = grp.vals[ci];
+        return res;
+    }
+
+    void PerfCounters::print(ostream& os, idx_t num_pts) {
+        if (_kind == no_counters)
+            return;
+        double npts = double(num_pts);
+        long long v0 = getSum(pc_0);
+        long long v1 = getSum(pc_1);
+        long long v2 = getSum(pc_2);
+
+        if (_kind == hw_counters) {
+            os << "hw-cycles (all threads):  " << printWithPow10Multiplier(double(v0)) << endl;
+            if (v1 >= 0) {
+                os << "hw-instructions:          " << printWithPow10Multiplier(double(v1)) << endl;
+                if (v0 > 0)
+                    os << "IPC:                      " << (double(v1) / double(v0)) << endl;
+            }
+            if (v2 >= 0)
+                os << "LLC-misses per point:     " << (double(v2) / npts) << endl;
+        }
+        else {
+            os << "sw-task-clock (sec, all threads): " << (double(v0) * 1e-9) << endl;
+            if (v1 >= 0)
+                os << "sw-context-switches:      " << v1 << endl;
+            if (v2 >= 0)
+                os << "sw-page-faults per point: " << (double(v2) / npts) << endl;
+        }
+
+        // Ratio of busiest to least-busy thread.
+        long long minv = getMin(pc_0);
+        if (minv > 0)
+            os << "thread imbalance (max/min " << getName(pc_0) << "): " <<
+                (double(getMax(pc_0)) / double(minv)) << endl;
+    }
+}
@@ -0,0 +1,125 @@
+/*****************************************************************************
+
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2016, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+// Hardware performance counters via the Linux perf_event_open() interface.
+// One group of counters is opened for each thread that runs stencil code,
+// so no VTune or external tool is needed. If the hardware counters are not
+// available (e.g., in a VM or due to perf_event_paranoid settings),
+// software counters are used instead. Define NO_PERF_COUNTERS to disable.
+
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__linux) && !defined(NO_PERF_COUNTERS)
+#define USE_PERF_COUNTERS
+#endif
+
+namespace yask {
+
+    struct StencilContext;
+
+    // Counters are kept per OS thread. A thread's counters are opened the
+    // first time it calls addThisThread(), so threads created after
+    // open(), e.g., by nested OpenMP, are also counted. Counters of threads
+    // that have exited keep their final values.
+    class PerfCounters {
+    public:
+
+        // Counters in each group.
+        // The 1st one is the group leader.
+        enum CounterIdx { pc_0, pc_1, pc_2, num_counters };
+
+        // Kinds of counter groups.
+        enum GroupKind { hw_counters, sw_counters, no_counters };
+
+    protected:
+
+        // File descriptors for one thread.
+        // Value is -1 if the counter could not be opened.
+        struct Group {
+            int fds[num_counters];
+            long long vals[num_counters]; // values read by stop().
+        };
+        static std::vector<Group> _groups;
+        static GroupKind _kind;
+        static bool _opened;    // open() has been called.
+        static bool _running;
+
+        // Open one group for the calling thread.
+        // Return false if leader could not be opened.
+        static bool openGroup(GroupKind kind);
+
+        // Open counters for the calling thread.
+        // Return false if open() has not been called yet.
+        static bool addThread();
+
+    public:
+
+        // Select the kind of counters and open them for all threads
+        // used by the stencil loops in context.
+        static void open(StencilContext& context);
+
+        // Open counters for the calling thread if not already done.
+        // Called at the beginning of each block, so it must be cheap.
+        static inline void addThisThread() {
+#ifdef USE_PERF_COUNTERS
+            static thread_local bool added = false;
+            if (!added)
+                added = addThread();
+#endif
+        }
+
+        // Get kind of counters opened.
+        static GroupKind getKind() { return _kind; }
+        static int getNumThreads() { return int(_groups.size()); }
+
+        // Name of each counter.
+        static std::string getName(int ci);
+
+        // Reset and start all counters.
+        static void start();
+
+        // Stop all counters and read values.
+        static void stop();
+
+        // Get sum over all threads of counter ci.
+        // Return -1 if not available.
+        static long long getSum(int ci);
+
+        // Get min and max over all threads that ran of counter ci.
+        static long long getMin(int ci);
+        static long long getMax(int ci);
+
+        // Print results from the last start/stop.
+        // num_pts is the number of points calculated in this rank.
+        static void print(std::ostream& os, idx_t num_pts);
+    };
+}
+
+#endif
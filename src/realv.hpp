@@ -34,6 +34,7 @@ IN THE SOFTWARE.
 #define NDEBUG
 #endif
 
+#include <cmath>
 #include <cstdint>
 #include <iostream>
 #include <string>
@@ -153,6 +154,18 @@ namespace yask {
 
 #undef VEC_ELEMS
 
+    // FMA instrs are in all 512-bit ISAs, but only in some 256-bit ones.
+#if defined(USE_INTRIN512) || defined(__FMA__)
+#define USE_FMA
+#endif
+
+    // Bit-mask with one bit per element of a real_vec_t.
+    // Bit 'i' corresponds to element 'i' in the linear (folded) order.
+#if VLEN > 64
+#error "Vector masks not supported for VLEN > 64"
+#endif
+    typedef ::uint64_t real_vec_mask_t;
+
     // Macro for looping through an aligned real_vec_t.
 #if defined(DEBUG) || (VLEN==1) || !defined(__INTEL_COMPILER) 
 #define REAL_VEC_LOOP(i)                        \
@@ -174,6 +187,7 @@ namespace yask {
 #else
 #define ALWAYS_INLINE __attribute__((always_inline)) inline
 #endif
+#define NEVER_INLINE __attribute__((noinline))
 
     // The following union is used to overlay C arrays with vector types.
     // It must be an aggregate type to allow aggregate initialization,
@@ -290,8 +304,8 @@ namespace yask {
             return u.r[l];
         }
 
-        // access a real_t by n,x,y,z vector-block indices.
-        ALWAYS_INLINE const real_t& operator()(idx_t n, idx_t i, idx_t j, idx_t k) const {
+        // get linear index of an element from n,x,y,z vector-block indices.
+        ALWAYS_INLINE static idx_t get_elem_index(idx_t n, idx_t i, idx_t j, idx_t k) {
             assert(n >= 0);
             assert(n < VLEN_N);
             assert(i >= 0);
@@ -304,14 +318,17 @@ namespace yask {
 #if VLEN_FIRST_DIM_IS_UNIT_STRIDE
 
             // n dim is unit stride, followed by x, y, z.
-            idx_t l = LAYOUT_4321(n, i, j, k, VLEN_N, VLEN_X, VLEN_Y, VLEN_Z);
+            return LAYOUT_4321(n, i, j, k, VLEN_N, VLEN_X, VLEN_Y, VLEN_Z);
 #else
 
             // z dim is unit stride, followed by y, x, n.
-            idx_t l = LAYOUT_1234(n, i, j, k, VLEN_N, VLEN_X, VLEN_Y, VLEN_Z);
+            return LAYOUT_1234(n, i, j, k, VLEN_N, VLEN_X, VLEN_Y, VLEN_Z);
 #endif
-        
-            return u.r[l];
+        }
+
+        // access a real_t by n,x,y,z vector-block indices.
+        ALWAYS_INLINE const real_t& operator()(idx_t n, idx_t i, idx_t j, idx_t k) const {
+            return u.r[get_elem_index(n, i, j, k)];
         }
         ALWAYS_INLINE real_t& operator()(idx_t n, idx_t i, idx_t j, idx_t k) {
             const real_vec_t* ct = const_cast<const real_vec_t*>(this);
@@ -390,6 +407,26 @@ namespace yask {
 #elif USE_RCP28
             rcp.u.mr = INAME(rcp28)(rhs.u.mr);
             res.u.mr = INAME(mul)(u.mr, rcp.u.mr);
+#elif defined(USE_RCP_DIV) && REAL_BYTES == 4 && defined(USE_FMA) && !defined(ARCH_KNC)
+            // Reciprocal estimate refined by one Newton-Raphson step,
+            // r' = r + r * (1 - d * r). The quotient q = n * r' may still
+            // be off by 1 ULP, which cancellation in stencils like awp
+            // can make visible, so it is corrected w/its residual,
+            // q' = q + r' * (n - d * q), which is correctly rounded
+            // except for some edge cases.
+#ifdef USE_INTRIN512
+            rcp.u.mr = INAME(rcp14)(rhs.u.mr);
+#else
+            rcp.u.mr = INAME(rcp)(rhs.u.mr);
+#endif
+            res.u.mr = INAME(fnmadd)(rhs.u.mr, rcp.u.mr, INAME(set1)(1.0f));
+            rcp.u.mr = INAME(fmadd)(rcp.u.mr, res.u.mr, rcp.u.mr);
+            res.u.mr = INAME(mul)(u.mr, rcp.u.mr);
+            {
+                real_vec_t resid;
+                resid.u.mr = INAME(fnmadd)(rhs.u.mr, res.u.mr, u.mr);
+                res.u.mr = INAME(fmadd)(resid.u.mr, rcp.u.mr, res.u.mr);
+            }
 #else
             res.u.mr = INAME(div)(u.mr, rhs.u.mr);
 #endif
@@ -473,6 +510,28 @@ namespace yask {
 #endif
         }
 
+        // unaligned store.
+        // (KNC has no single unaligned-store instruction.)
+        ALWAYS_INLINE void storeUnalignedTo(real_vec_t* __restrict__ to) const {
+#if defined(NO_INTRINSICS) || defined(NO_STORE_INTRINSICS) || defined(ARCH_KNC)
+            REAL_VEC_LOOP_UNALIGNED(i) (*to)[i] = u.r[i];
+#else
+            INAME(storeu)((imem_t*)to, u.mr);
+#endif
+        }
+
+        // aligned store of only the elements whose bits are set in mask.
+        // Used for partial clusters at the edge of the domain, so
+        // streaming stores are not used.
+        ALWAYS_INLINE void storeMaskedTo(real_vec_t* __restrict__ to,
+                                         real_vec_mask_t mask) const {
+#if defined(NO_INTRINSICS) || defined(NO_STORE_INTRINSICS) || !defined(USE_INTRIN512)
+            REAL_VEC_LOOP(i) if ((mask >> i) & 1) (*to)[i] = u.r[i];
+#else
+            INAME(mask_store)((imem_t*)to, real_mask_t(mask), u.mr);
+#endif
+        }
+
         // Output.
         void print_ctrls(std::ostream& os, bool doEnd=true) const {
             for (int j = 0; j < VLEN; j++) {
@@ -514,6 +573,59 @@ namespace yask {
         return real_vec_t(lhs) / rhs;
     }
 
+    // Scalar fused multiply-add and variants, used in the reference code
+    // and in the vector code below when intrinsics are emulated, so that
+    // both round the same way.
+    ALWAYS_INLINE real_t real_fmadd(real_t a, real_t b, real_t c) {
+#ifdef USE_FMA
+        return std::fma(a, b, c);
+#else
+        return a * b + c;
+#endif
+    }
+    ALWAYS_INLINE real_t real_fmsub(real_t a, real_t b, real_t c) {
+        return real_fmadd(a, b, -c);
+    }
+    ALWAYS_INLINE real_t real_fnmadd(real_t a, real_t b, real_t c) {
+        return real_fmadd(-a, b, c);
+    }
+
+    // Fused multiply-add: a * b + c.
+    ALWAYS_INLINE real_vec_t real_vec_fmadd(const real_vec_t& a, const real_vec_t& b,
+                                            const real_vec_t& c) {
+        real_vec_t res;
+#if defined(USE_FMA) && !defined(NO_INTRINSICS)
+        res.u.mr = INAME(fmadd)(a.u.mr, b.u.mr, c.u.mr);
+#else
+        REAL_VEC_LOOP(i) res[i] = real_fmadd(a[i], b[i], c[i]);
+#endif
+        return res;
+    }
+
+    // Fused multiply-subtract: a * b - c.
+    ALWAYS_INLINE real_vec_t real_vec_fmsub(const real_vec_t& a, const real_vec_t& b,
+                                            const real_vec_t& c) {
+        real_vec_t res;
+#if defined(USE_FMA) && !defined(NO_INTRINSICS)
+        res.u.mr = INAME(fmsub)(a.u.mr, b.u.mr, c.u.mr);
+#else
+        REAL_VEC_LOOP(i) res[i] = real_fmsub(a[i], b[i], c[i]);
+#endif
+        return res;
+    }
+
+    // Fused negated multiply-add: -(a * b) + c.
+    ALWAYS_INLINE real_vec_t real_vec_fnmadd(const real_vec_t& a, const real_vec_t& b,
+                                             const real_vec_t& c) {
+        real_vec_t res;
+#if defined(USE_FMA) && !defined(NO_INTRINSICS)
+        res.u.mr = INAME(fnmadd)(a.u.mr, b.u.mr, c.u.mr);
+#else
+        REAL_VEC_LOOP(i) res[i] = real_fnmadd(a[i], b[i], c[i]);
+#endif
+        return res;
+    }
+
     // wrappers around some intrinsics w/non-intrinsic equivalents.
     // TODO: make these methods in the real_vec_t union.
 
@@ -0,0 +1,265 @@
+/*****************************************************************************
+
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2016, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+// Kernels for the real_vec_t microbenchmark.
+// This file is compiled twice: normally, and with REALV_BENCH_EMU
+// defined to get the NO_INTRINSICS versions of the primitives.
+// In the latter case, the 'yask' namespace in realv.hpp is renamed to
+// 'yask_emu' so the two different definitions of real_vec_t don't
+// collide at link time.
+
+#include <time.h>
+#include "realv_bench.hpp"
+
+#ifdef REALV_BENCH_EMU
+#define NO_INTRINSICS
+#define yask yask_emu
+#define RUN_REALV_BENCH run_realv_bench_emu
+#else
+#define RUN_REALV_BENCH run_realv_bench
+#endif
+
+// Streaming stores are timed separately below, so make storeTo()
+// a normal store regardless of the build setting.
+#undef USE_STREAMING_STORE
+
+#include "stencil_macros.hpp"
+#include "realv.hpp"
+
+namespace {
+
+    // Types and functions from realv.hpp; these are in yask_emu if
+    // REALV_BENCH_EMU.
+    using namespace yask;
+
+    // Prevent the compiler from optimizing across the benchmarked ops.
+    // With intrinsics, the vector is kept in a register.  Without them,
+    // it is forced to memory; otherwise, the compiler could combine a
+    // series of emulated element moves into one. This slightly overstates
+    // the emulated latencies.
+#if defined(NO_INTRINSICS)
+#define BENCH_KEEP(v) asm volatile("" : "+m"(v))
+#elif defined(USE_INTRIN512)
+#define BENCH_KEEP(v) asm volatile("" : "+v"((v).u.mr))
+#else
+#define BENCH_KEEP(v) asm volatile("" : "+x"((v).u.mr))
+#endif
+
+    // Make sure all stores to p are done.
+#define BENCH_SINK(p) asm volatile("" : : "r"(p) : "memory")
+
+    // Number of independent dependency chains in throughput tests.
+    const int num_chains = 4;
+
+    // Bit mask w/every other element selected.
+    const unsigned int alt_mask = 0x5555 & ((1u << VLEN) - 1);
+
+    double nowInSecs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return double(ts.tv_sec) + 1e-09 * double(ts.tv_nsec);
+    }
+
+    // Inputs to the in-register ops.
+    struct BenchInputs {
+        real_vec_t a, b;
+        real_vec_t ctrl1;           // reverses elements.
+        real_vec_t ctrl2;           // interleaves elements of 2 vectors.
+
+        BenchInputs() {
+            for (int i = 0; i < VLEN; i++) {
+                a[i] = real_t(i);
+                b[i] = real_t(i + VLEN);
+                ctrl1.u.ci[i] = ctrl_t(VLEN - 1 - i);
+                ctrl2.u.ci[i] = ctrl_t(i / 2) | ((i & 1) ? ctrl_sel_bit : 0);
+            }
+        }
+    };
+
+    // Return best secs per op for 'nops' calls to 'op' in one dependency
+    // chain, i.e., the latency of 'op'.
+    template <typename OpFn>
+    double timeLatency(OpFn op, const BenchInputs& in, int64_t nops, int ntrials) {
+        double best = 0.;
+        for (int trial = 0; trial < ntrials; trial++) {
+            real_vec_t r0 = in.a;
+            double start = nowInSecs();
+            for (int64_t i = 0; i < nops; i++) {
+                op(r0);
+                BENCH_KEEP(r0);
+            }
+            double secs = nowInSecs() - start;
+            BENCH_SINK(&r0);
+            if (trial == 0 || secs < best)
+                best = secs;
+        }
+        return best / nops;
+    }
+
+    // Return best secs per op for 'nops' calls to 'op' spread over
+    // num_chains independent chains, i.e., the reciprocal throughput of 'op'.
+    template <typename OpFn>
+    double timeThroughput(OpFn op, const BenchInputs& in, int64_t nops, int ntrials) {
+        double best = 0.;
+        for (int trial = 0; trial < ntrials; trial++) {
+            real_vec_t r0 = in.a, r1 = in.b, r2 = in.a, r3 = in.b;
+            double start = nowInSecs();
+            for (int64_t i = 0; i < nops; i += num_chains) {
+                op(r0);
+                op(r1);
+                op(r2);
+                op(r3);
+                BENCH_KEEP(r0);
+                BENCH_KEEP(r1);
+                BENCH_KEEP(r2);
+                BENCH_KEEP(r3);
+            }
+            double secs = nowInSecs() - start;
+            BENCH_SINK(&r0);
+            BENCH_SINK(&r1);
+            BENCH_SINK(&r2);
+            BENCH_SINK(&r3);
+            if (trial == 0 || secs < best)
+                best = secs;
+        }
+        return best / nops;
+    }
+
+    // Return best secs per op for 'op(buf, i, v)' called on each of the
+    // 'nvecs' vectors in 'buf', repeated until 'nops' ops are done.
+    // 'v' is a local copy of 'val', so it cannot alias 'buf'.
+    template <typename OpFn>
+    double timeMemOp(OpFn op, real_vec_t* buf, const real_vec_t& val,
+                     int64_t nvecs, int64_t nops, int ntrials) {
+        int64_t npasses = (nops + nvecs - 1) / nvecs;
+        double best = 0.;
+        for (int trial = 0; trial < ntrials; trial++) {
+            real_vec_t v = val;
+            BENCH_KEEP(v);
+            double start = nowInSecs();
+            for (int64_t j = 0; j < npasses; j++) {
+                for (int64_t i = 0; i < nvecs; i++)
+                    op(buf, i, v);
+                BENCH_SINK(buf);
+            }
+#if !defined(NO_INTRINSICS)
+            _mm_sfence();       // finish any streaming stores.
+#endif
+            double secs = nowInSecs() - start;
+            if (trial == 0 || secs < best)
+                best = secs;
+        }
+        return best / (npasses * nvecs);
+    }
+
+    // Non-temporal store.
+    // Same as storeTo() w/USE_STREAMING_STORE, but that can't be
+    // used here because it is selected at compile time.
+    ALWAYS_INLINE void streamTo(const real_vec_t& v, real_vec_t* __restrict__ to) {
+#if defined(NO_INTRINSICS)
+        REAL_VEC_LOOP(i) (*to)[i] = v[i];
+#elif defined(ARCH_KNC)
+        INAME(storenrngo)((real_t*)to, v.u.mr);
+#else
+        INAME(stream)((real_t*)to, v.u.mr);
+#endif
+    }
+}
+
+#ifdef REALV_BENCH_EMU
+#undef yask
+#endif
+
+namespace yask {
+
+    void RUN_REALV_BENCH(RealVecBenchResults& results,
+                         int64_t nbytes, int64_t nops, int ntrials) {
+        BenchInputs in;
+        BENCH_SINK(&in);        // don't let the compiler see the values.
+        nops = (nops + num_chains - 1) / num_chains * num_chains;
+
+#define ADD_RESULT(name, secs, bytes) \
+        results.push_back(RealVecBenchResult { name, (secs) * 1e9, bytes })
+
+        // In-register ops.
+        // Each is run as a latency test and a throughput test.
+#define REG_BENCH(name, stmt) do {                                      \
+            auto op = [&](real_vec_t& r) { stmt; };                     \
+            ADD_RESULT(name " latency", timeLatency(op, in, nops, ntrials), 0); \
+            ADD_RESULT(name " throughput", timeThroughput(op, in, nops, ntrials), 0); \
+        } while(0)
+
+        REG_BENCH("align<1>", real_vec_align<1>(r, r, in.b));
+        REG_BENCH("align<1> masked", real_vec_align_masked<1>(r, r, in.b, alt_mask));
+        REG_BENCH("permute", real_vec_permute(r, in.ctrl1, r));
+        REG_BENCH("permute masked", real_vec_permute_masked(r, in.ctrl1, r, alt_mask));
+#if !defined(ARCH_KNC) || defined(NO_INTRINSICS)
+        REG_BENCH("permute2", real_vec_permute2(r, in.ctrl2, r, in.b));
+#endif
+#undef REG_BENCH
+
+        // Memory ops.
+        // The unaligned tests are offset by one element, so one extra
+        // vector is allocated.
+        int64_t vbytes = sizeof(real_vec_t);
+        int64_t nvecs = nbytes / vbytes;
+        if (nvecs < 1)
+            nvecs = 1;
+        real_vec_t* buf = 0;
+        if (posix_memalign((void**)&buf, 64, (nvecs + 1) * vbytes)) {
+            std::cerr << "error: cannot allocate " << ((nvecs + 1) * vbytes) <<
+                " bytes for benchmark buffer." << std::endl;
+            exit(1);
+        }
+        for (int64_t i = 0; i <= nvecs; i++)
+            buf[i] = in.a;
+
+        ADD_RESULT("load aligned",
+                   timeMemOp([](real_vec_t* p, int64_t i, real_vec_t& v) {
+                           v.loadFrom(&p[i]);
+                           BENCH_KEEP(v);
+                       }, buf, in.b, nvecs, nops, ntrials), vbytes);
+        ADD_RESULT("load unaligned",
+                   timeMemOp([](real_vec_t* p, int64_t i, real_vec_t& v) {
+                           v.loadUnalignedFrom((real_vec_t*)((real_t*)&p[i] + 1));
+                           BENCH_KEEP(v);
+                       }, buf, in.b, nvecs, nops, ntrials), vbytes);
+        ADD_RESULT("store aligned",
+                   timeMemOp([](real_vec_t* p, int64_t i, real_vec_t& v) {
+                           v.storeTo(&p[i]);
+                       }, buf, in.b, nvecs, nops, ntrials), vbytes);
+        ADD_RESULT("store unaligned",
+                   timeMemOp([](real_vec_t* p, int64_t i, real_vec_t& v) {
+                           v.storeUnalignedTo((real_vec_t*)((real_t*)&p[i] + 1));
+                       }, buf, in.b, nvecs, nops, ntrials), vbytes);
+        ADD_RESULT("store streaming",
+                   timeMemOp([](real_vec_t* p, int64_t i, real_vec_t& v) {
+                           streamTo(v, &p[i]);
+                       }, buf, in.b, nvecs, nops, ntrials), vbytes);
+#undef ADD_RESULT
+
+        free(buf);
+    }
+}
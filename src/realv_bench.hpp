@@ -0,0 +1,63 @@
+/*****************************************************************************
+
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2016, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+// Microbenchmark of real_vec_t primitives.
+// The kernels in realv_bench.cpp are compiled twice: once as configured
+// by the build and once with NO_INTRINSICS, so the intrinsic and
+// emulated versions of each primitive can be timed in the same run.
+// See realv_bench_main.cpp for the driver.
+
+#ifndef REALV_BENCH_HPP
+#define REALV_BENCH_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace yask {
+
+    // Timing of one primitive.
+    struct RealVecBenchResult {
+        std::string name;
+        double ns_per_op;       // best time per real_vec_t op.
+        int64_t bytes_per_op;   // memory traffic per op; 0 for in-register ops.
+    };
+    typedef std::vector<RealVecBenchResult> RealVecBenchResults;
+
+    // Time each primitive.
+    // nbytes: size of buffer used by the load and store tests.
+    // nops: number of ops timed in each trial.
+    // ntrials: number of trials; the fastest one is reported.
+
+    // Version using intrinsics as configured by the build.
+    extern void run_realv_bench(RealVecBenchResults& results,
+                                int64_t nbytes, int64_t nops, int ntrials);
+
+    // Version built with NO_INTRINSICS.
+    extern void run_realv_bench_emu(RealVecBenchResults& results,
+                                    int64_t nbytes, int64_t nops, int ntrials);
+}
+
+#endif
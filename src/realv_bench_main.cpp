@@ -0,0 +1,142 @@
+/*****************************************************************************
+
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2016, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+// Driver for the real_vec_t microbenchmark.
+// Times each primitive with intrinsics and with the NO_INTRINSICS
+// emulation for the VLEN and REAL_BYTES of this build.
+
+#include <iomanip>
+#include "stencil_macros.hpp"
+#include "realv.hpp"
+#include "realv_bench.hpp"
+
+using namespace std;
+using namespace yask;
+
+int main(int argc, char** argv)
+{
+    // options and their defaults.
+    int kb = 16;                // KiB in load/store buffer.
+    int nops = 10000000;        // ops per trial.
+    int num_trials = 5;         // number of trials.
+
+    // parse options.
+    for (int argi = 1; argi < argc; argi++) {
+        if ( argv[argi][0] == '-' && argv[argi][1] ) {
+            string opt = argv[argi];
+
+            // options w/o values.
+            if (opt == "-h" || opt == "-help" || opt == "--help") {
+                cout << 
+                    "Usage: [options]\n"
+                    "Options:\n"
+                    " -h:              print this help and exit\n"
+                    " -t <n>           number of trials; the fastest is reported, default=" <<
+                    num_trials << endl <<
+                    " -n <n>           number of ops per trial, default=" <<
+                    nops << endl <<
+                    " -kb <n>          KiB of memory used by load and store tests, default=" <<
+                    kb << endl <<
+                    "Notes:\n"
+                    " Latency is time per op in one dependency chain.\n"
+                    " Throughput is time per op in independent chains.\n"
+                    " Use a -kb value larger than the LLC to measure streaming stores.\n"
+                    "Examples:\n" <<
+                    " " << argv[0] << "\n" <<
+                    " " << argv[0] << " -kb 262144 -n 100000000  # main-memory bandwidth.\n";
+                exit(0);
+            }
+
+            // options w/int values.
+            else {
+
+                if (argi + 1 >= argc) {
+                    cerr << "error: no value for option '" << opt << "'." << endl;
+                    exit(1);
+                }
+                int val = atoi(argv[++argi]);
+                if (opt == "-t") num_trials = val;
+                else if (opt == "-n") nops = val;
+                else if (opt == "-kb") kb = val;
+                else {
+                    cerr << "error: option '" << opt << "' not recognized." << endl;
+                    exit(1);
+                }
+            }
+        }
+        else {
+            cerr << "error: extraneous parameter '" <<
+                argv[argi] << "'." << endl;
+            exit(1);
+        }
+    }
+    if (num_trials < 1 || nops < 1 || kb < 1) {
+        cerr << "error: option values must be positive." << endl;
+        exit(1);
+    }
+
+    cout << "real_vec_t microbenchmark" << endl <<
+        " stencil: " STENCIL_NAME << endl <<
+        " vector-fold: " << VLEN_N << '*' << VLEN_X << '*' << VLEN_Y << '*' << VLEN_Z <<
+        " (VLEN=" << VLEN << ")" << endl <<
+        " real-bytes: " << REAL_BYTES << endl <<
+#if defined(NO_INTRINSICS)
+        " intrinsics: none; both columns are emulated" << endl <<
+#elif defined(USE_INTRIN512)
+        " intrinsics: 512-bit" << endl <<
+#else
+        " intrinsics: 256-bit" << endl <<
+#endif
+#ifdef NO_STORE_INTRINSICS
+        " note: built with NO_STORE_INTRINSICS" << endl <<
+#endif
+        " num-trials: " << num_trials << endl <<
+        " ops-per-trial: " << nops << endl <<
+        " buffer-size: " << kb << " KiB" << endl;
+
+    RealVecBenchResults intrin, emul;
+    run_realv_bench(intrin, int64_t(kb) * 1024, nops, num_trials);
+    run_realv_bench_emu(emul, int64_t(kb) * 1024, nops, num_trials);
+    assert(intrin.size() == emul.size());
+
+    // ns/op and GB/s for both versions; 'ratio' is emulated/intrinsic
+    // time, so > 1 means the intrinsic version is faster.
+    cout << endl << left << setw(28) << "primitive" << right <<
+        setw(12) << "intrin-ns" << setw(12) << "emul-ns" << setw(10) << "ratio" <<
+        setw(12) << "intrin-GB/s" << setw(12) << "emul-GB/s" << endl;
+    cout << fixed;
+    for (size_t i = 0; i < intrin.size(); i++) {
+        auto& ri = intrin[i];
+        auto& re = emul[i];
+        cout << left << setw(28) << ri.name << right << setprecision(3) <<
+            setw(12) << ri.ns_per_op << setw(12) << re.ns_per_op <<
+            setprecision(2) << setw(10) << (re.ns_per_op / ri.ns_per_op);
+        if (ri.bytes_per_op)
+            cout << setw(12) << (ri.bytes_per_op / ri.ns_per_op) <<
+                setw(12) << (re.bytes_per_op / re.ns_per_op);
+        cout << endl;
+    }
+    return 0;
+}
@@ -87,6 +87,34 @@ namespace yask {
             return _gp->compare(ref._gp, ev, maxPrint, os);
         }
 
+        // Get index in the underlying 4D grid for time t and index n.
+        // Overridden by grids with a time dim.
+        virtual idx_t get_mat_index(idx_t t, idx_t n) const {
+            return n;
+        }
+
+        // Get padding in each dim after round-up; 0 if the grid does
+        // not have the dim. Overridden by grids that have padding.
+        virtual idx_t get_pn() const { return 0; }
+        virtual idx_t get_px() const { return 0; }
+        virtual idx_t get_py() const { return 0; }
+        virtual idx_t get_pz() const { return 0; }
+
+        // Read and write one vector in the underlying 4D grid at index
+        // n from get_mat_index() and vector offset iv, jv, kv, whatever
+        // the layout. Used for halo exchange, not in the stencil kernels.
+        // Overridden by 4D grids; only they may have their halos exchanged.
+        virtual real_vec_t readVecMat(idx_t n, idx_t iv, idx_t jv, idx_t kv,
+                                      int line) const {
+            std::cerr << "Error: grid '" << _name << "' has no 4D data." << std::endl;
+            exit(1);
+        }
+        virtual void writeVecMat(const real_vec_t& v, idx_t n, idx_t iv, idx_t jv, idx_t kv,
+                                 int line) {
+            std::cerr << "Error: grid '" << _name << "' has no 4D data." << std::endl;
+            exit(1);
+        }
+
         // Direct access to data (dangerous!).
         real_vec_t* getRawData() {
             return _gp->getRawData();
@@ -155,9 +183,9 @@ namespace yask {
         inline idx_t get_dx() { return _dx; }
         inline idx_t get_dy() { return _dy; }
         inline idx_t get_dz() { return _dz; }
-        inline idx_t get_px() { return _px; }
-        inline idx_t get_py() { return _py; }
-        inline idx_t get_pz() { return _pz; }
+        virtual idx_t get_px() const { return _px; }
+        virtual idx_t get_py() const { return _py; }
+        virtual idx_t get_pz() const { return _pz; }
 
         // Get pointer to the real_vec_t at vector offset iv, jv, kv.
         // Indices must be normalized, i.e., already divided by VLEN_*.
@@ -329,6 +357,22 @@ namespace yask {
 #ifdef TRACE_MEM
             printVec("writeVec", iv, jv, kv, v, line);
 #endif
+#ifdef MODEL_CACHE
+            cache.write(p, line);
+#endif
+        }
+
+        // Write elements of one vector selected by mask at vector offset iv, jv, kv.
+        // Indices must be normalized, i.e., already divided by VLEN_*.
+        ALWAYS_INLINE void writeVecNormMasked(const real_vec_t& v, real_vec_mask_t mask,
+                                              idx_t iv, idx_t jv, idx_t kv,
+                                              int line) {
+            real_vec_t* p = getVecPtrNorm(iv, jv, kv);
+            __assume_aligned(p, CACHELINE_BYTES);
+            v.storeMaskedTo(p, mask);
+#ifdef TRACE_MEM
+            printVec("writeVecMasked", iv, jv, kv, v, line);
+#endif
 #ifdef MODEL_CACHE
             cache.write(p, line);
 #endif
@@ -336,6 +380,124 @@ namespace yask {
 
     };
 
+    // A 1D collection of real_t elements along spatial dimension
+    // Dim (1=x, 2=y, 3=z), e.g., a separable boundary profile.
+    // Each real_vec_t holds VLEN_<Dim> consecutive elements, each
+    // broadcast across the other dimensions of the fold, so a vector
+    // read can be used directly with vectors of 3D grids.
+    // Supports symmetric padding.
+    template <int Dim> class RealVecGrid_1D :
+        public RealVecGridBase {
+    protected:
+
+        // Vector length in Dim.
+        static const idx_t _vlen = (Dim == 1) ? VLEN_X :
+            (Dim == 2) ? VLEN_Y : VLEN_Z;
+        
+        // real sizes.
+        idx_t _d, _p;
+
+        // real_vec_t sizes.
+        idx_t _dv, _pv;
+
+        GenericGrid1d<real_vec_t, Layout_1> _data;
+
+    public:
+
+        // Ctor.
+        // Dimensions are real_t elements, not real_vecs.
+        RealVecGrid_1D(idx_t d, idx_t p,
+                       const std::string& name,
+                       std::ostream& msg_stream = std::cout) :
+            RealVecGridBase(name, &_data),
+            _d(ROUND_UP(d, _vlen)),
+            _p(ROUND_UP(p, _vlen)),
+            _dv(_d / _vlen),
+            _pv(_p / _vlen),
+            _data(_dv + 2*_pv, ALLOC_ALIGNMENT)
+        {
+            _data.print_info(name, msg_stream);
+        }
+
+        // Get parameters after round-up.
+        inline idx_t get_d() { return _d; }
+        inline idx_t get_p() { return _p; }
+
+        // Initialize memory to a given value.
+        virtual void set_same(real_t val) {
+            for (idx_t i = -_p; i < _d + _p; i++)
+                writeElem(val, i, 0);
+        }
+
+        // Initialize memory to incrementing values based on val.
+        // Values must be set by element to keep them broadcast.
+        virtual void set_diff(real_t val) {
+            for (idx_t i = -_p; i < _d + _p; i++)
+                writeElem(real_t((i + _p) % VLEN + 1) * val, i, 0);
+        }
+
+        // Get pointer to the real_vec_t at vector offset iv.
+        // Index must be normalized, i.e., already divided by VLEN_<Dim>.
+        ALWAYS_INLINE const real_vec_t* getVecPtrNorm(idx_t iv,
+                                                      bool checkBounds=true) const {
+            return &_data(iv + _pv, checkBounds);
+        }
+
+        // Non-const version.
+        ALWAYS_INLINE real_vec_t* getVecPtrNorm(idx_t iv,
+                                                bool checkBounds=true) {
+            return &_data(iv + _pv, checkBounds);
+        }
+
+        // Read one element.
+        ALWAYS_INLINE real_t readElem(idx_t i, int line) const {
+
+            // add padding before division to ensure negative indices work.
+            idx_t ip = i + _p;
+            const real_vec_t* vp = getVecPtrNorm(ip / _vlen - _pv);
+            idx_t ie = ip % _vlen;
+            real_t e = (*vp)(0, (Dim == 1) ? ie : 0, (Dim == 2) ? ie : 0, (Dim == 3) ? ie : 0);
+#ifdef TRACE_MEM
+            std::cout << "readElem: " << _name << "[" << i << "] = " << e <<
+                " at line " << line << std::endl << std::flush;
+#endif
+            return e;
+        }
+
+        // Write one element, broadcasting it across the other dimensions.
+        ALWAYS_INLINE void writeElem(real_t val, idx_t i, int line) {
+            idx_t ip = i + _p;
+            real_vec_t* vp = getVecPtrNorm(ip / _vlen - _pv);
+            idx_t ie = ip % _vlen;
+            for (int n = 0; n < VLEN_N; n++)
+                for (int i2 = 0; i2 < VLEN_X; i2++)
+                    for (int j2 = 0; j2 < VLEN_Y; j2++)
+                        for (int k2 = 0; k2 < VLEN_Z; k2++)
+                            if (((Dim == 1) ? i2 : (Dim == 2) ? j2 : k2) == ie)
+                                (*vp)(n, i2, j2, k2) = val;
+#ifdef TRACE_MEM
+            std::cout << "writeElem: " << _name << "[" << i << "] = " << val <<
+                " at line " << line << std::endl << std::flush;
+#endif
+        }
+
+        // Read one vector at vector offset iv.
+        // Index must be normalized, i.e., already divided by VLEN_<Dim>.
+        ALWAYS_INLINE const real_vec_t readVecNorm(idx_t iv, int line) const {
+            const real_vec_t* p = getVecPtrNorm(iv);
+            __assume_aligned(p, CACHELINE_BYTES);
+            real_vec_t v;
+            v.loadFrom(p);
+#ifdef MODEL_CACHE
+            cache.read(p, line);
+#endif
+            return v;
+        }
+    };
+    typedef RealVecGrid_1D<1> RealVecGrid_X;
+    typedef RealVecGrid_1D<2> RealVecGrid_Y;
+    typedef RealVecGrid_1D<3> RealVecGrid_Z;
+
     // A 4D (n, x, y, z) collection of real_vec_t elements.
     // Supports symmetric padding in each dimension.
     template <typename LayoutFn> class RealVecGrid_NXYZ :
@@ -398,10 +560,10 @@ namespace yask {
         inline idx_t get_dx() { return _dx; }
         inline idx_t get_dy() { return _dy; }
         inline idx_t get_dz() { return _dz; }
-        inline idx_t get_pn() { return _pn; }
-        inline idx_t get_px() { return _px; }
-        inline idx_t get_py() { return _py; }
-        inline idx_t get_pz() { return _pz; }
+        virtual idx_t get_pn() const { return _pn; }
+        virtual idx_t get_px() const { return _px; }
+        virtual idx_t get_py() const { return _py; }
+        virtual idx_t get_pz() const { return _pz; }
 
         // Get pointer to the real_vec_t at vector offset nv, iv, jv, kv.
         // Indices must be normalized, i.e., already divided by VLEN_*.
@@ -587,6 +749,33 @@ namespace yask {
 #ifdef TRACE_MEM
             printVec("writeVec", nv, iv, jv, kv, v, line);
 #endif
+#ifdef MODEL_CACHE
+            cache.write(p, line);
+#endif
+        }
+
+        // Read and write one vector for halo exchange.
+        // Not overridden by grids w/a time dim: n is already mapped.
+        virtual real_vec_t readVecMat(idx_t n, idx_t iv, idx_t jv, idx_t kv,
+                                      int line) const {
+            return RealVecGrid_NXYZ::readVecNorm(n, iv, jv, kv, line);
+        }
+        virtual void writeVecMat(const real_vec_t& v, idx_t n, idx_t iv, idx_t jv, idx_t kv,
+                                 int line) {
+            RealVecGrid_NXYZ::writeVecNorm(v, n, iv, jv, kv, line);
+        }
+
+        // Write elements of one vector selected by mask at vector offset nv, iv, jv, kv.
+        // Indices must be normalized, i.e., already divided by VLEN_*.
+        ALWAYS_INLINE void writeVecNormMasked(const real_vec_t& v, real_vec_mask_t mask,
+                                              idx_t nv, idx_t iv, idx_t jv, idx_t kv,
+                                              int line) {
+            real_vec_t* p = getVecPtrNorm(nv, iv, jv, kv);
+            __assume_aligned(p, CACHELINE_BYTES);
+            v.storeMaskedTo(p, mask);
+#ifdef TRACE_MEM
+            printVec("writeVecMasked", nv, iv, jv, kv, v, line);
+#endif
 #ifdef MODEL_CACHE
             cache.write(p, line);
 #endif
@@ -595,9 +784,9 @@ namespace yask {
     };
 
     // A 4D (t, x, y, z) collection of real_vec_t elements, but any value of 't'
-    // is divided by CPTS_T and wrapped to TIME_DIM_SIZE indices.
+    // is divided by CPTS_T and wrapped to TimeSlots indices.
     // Supports symmetric padding in each spatial dimension.
-    template <typename LayoutFn> class RealVecGrid_TXYZ :
+    template <typename LayoutFn, idx_t TimeSlots = TIME_DIM_SIZE> class RealVecGrid_TXYZ :
         public RealVecGrid_NXYZ<LayoutFn>  {
     
     public:
@@ -607,7 +796,7 @@ namespace yask {
                          idx_t px, idx_t py, idx_t pz,
                          const std::string& name,
                          std::ostream& msg_stream = std::cout) :
-            RealVecGrid_NXYZ<LayoutFn>(TIME_DIM_SIZE, dx, dy, dz,
+            RealVecGrid_NXYZ<LayoutFn>(TimeSlots, dx, dy, dz,
                                        0, px, py, pz,
                                        name, msg_stream)
         {
@@ -626,8 +815,8 @@ namespace yask {
             assert(imod<idx_t>(t, CPTS_T) == 0);
             idx_t t_idx = idiv<idx_t>(t, CPTS_T);
 
-            // Index wraps in TIME_DIM_SIZE.
-            // Examples if TIME_DIM_SIZE == 2:
+            // Index wraps in TimeSlots.
+            // Examples if TimeSlots == 2:
             // t_idx => return value.
             // -2 => 0.
             // -1 => 1.
@@ -635,16 +824,21 @@ namespace yask {
             //  1 => 1.
 
             // Use imod to allow t to be negative.
-            return imod<idx_t>(t_idx, TIME_DIM_SIZE);
+            return imod<idx_t>(t_idx, TimeSlots);
 #else
             // version that doesn't allow negative time.
             assert(t >= 0);
             assert(t % CPTS_T == 0);
             idx_t t_idx = t / idx_t(CPTS_T);
-            return t_idx % idx_t(TIME_DIM_SIZE);
+            return t_idx % idx_t(TimeSlots);
 #endif
         }
 
+        // Get index in the underlying 4D grid.
+        virtual idx_t get_mat_index(idx_t t, idx_t n) const {
+            return getMatIndex(t);
+        }
+
         // Read one element.
         ALWAYS_INLINE real_t readElem(idx_t t, idx_t i, idx_t j, idx_t k,
                                     int line) const {
@@ -675,6 +869,15 @@ namespace yask {
             RealVecGrid_NXYZ<LayoutFn>::writeVecNorm(v, n, iv, jv, kv, line);
         }
 
+        // Write elements of one vector selected by mask at t and vector offset iv, jv, kv.
+        // Indices must be normalized, i.e., already divided by VLEN_*.
+        ALWAYS_INLINE void writeVecNormMasked(const real_vec_t& v, real_vec_mask_t mask,
+                                              idx_t t, idx_t iv, idx_t jv, idx_t kv,
+                                              int line) {
+            idx_t n = getMatIndex(t);
+            RealVecGrid_NXYZ<LayoutFn>::writeVecNormMasked(v, mask, n, iv, jv, kv, line);
+        }
+
         // Get pointer to the real at t and offset i, j, k.
         ALWAYS_INLINE const real_t* getElemPtr(idx_t t, idx_t i, idx_t j, idx_t k,
                                              int line) const {
@@ -702,9 +905,9 @@ namespace yask {
     };
 
     // A 5D (t, n, x, y, z) collection of real_vec_t elements, but any value of 't'
-    // is divided by CPTS_T and wrapped to TIME_DIM_SIZE indices.
+    // is divided by CPTS_T and wrapped to TimeSlots indices.
     // Supports symmetric padding in each spatial dimension.
-    template <typename LayoutFn> class RealVecGrid_TNXYZ :
+    template <typename LayoutFn, idx_t TimeSlots = TIME_DIM_SIZE> class RealVecGrid_TNXYZ :
         public RealVecGrid_NXYZ<LayoutFn> {
     
     protected:
@@ -717,7 +920,7 @@ namespace yask {
                           idx_t pn, idx_t px, idx_t py, idx_t pz,
                           const std::string& name,
                           std::ostream& msg_stream = std::cout) :
-            RealVecGrid_NXYZ<LayoutFn>(TIME_DIM_SIZE * dn, dx, dy, dz,
+            RealVecGrid_NXYZ<LayoutFn>(TimeSlots * dn, dx, dy, dz,
                                        pn, px, py, pz,
                                        name, msg_stream),
             _dn(dn)
@@ -737,8 +940,8 @@ namespace yask {
             assert(imod<idx_t>(t, CPTS_T) == 0);
             idx_t t_idx = idiv<idx_t>(t, CPTS_T);
 
-            // Index wraps in TIME_DIM_SIZE.
-            // Examples if TIME_DIM_SIZE == 2:
+            // Index wraps in TimeSlots.
+            // Examples if TimeSlots == 2:
             // t_idx => t_idx2.
             // -2 => 0.
             // -1 => 1.
@@ -746,17 +949,22 @@ namespace yask {
             //  1 => 1.
 
             // Use imod to allow t to be negative.
-            idx_t t_idx2 = imod<idx_t>(t_idx, TIME_DIM_SIZE);
+            idx_t t_idx2 = imod<idx_t>(t_idx, TimeSlots);
 #else
             // version that doesn't allow negative time.
             assert(t >= 0);
             assert(t % CPTS_T == 0);
             idx_t t_idx = t / idx_t(CPTS_T);
-            idx_t t_idx2 = t_idx % idx_t(TIME_DIM_SIZE);
+            idx_t t_idx2 = t_idx % idx_t(TimeSlots);
 #endif        
 
             // Layout t_idx2 and n onto one dimension.
-            return LAYOUT_21(n, t_idx2, _dn, TIME_DIM_SIZE);
+            return LAYOUT_21(n, t_idx2, _dn, TimeSlots);
+        }
+
+        // Get index in the underlying 4D grid.
+        virtual idx_t get_mat_index(idx_t t, idx_t n) const {
+            return getMatIndex(t, n);
         }
 
         // Read one element.
@@ -793,6 +1001,16 @@ namespace yask {
             RealVecGrid_NXYZ<LayoutFn>::writeVecNorm(v, n2, iv, jv, kv, line);
         }
 
+        // Write elements of one vector selected by mask at t and vector offset nv, iv, jv, kv.
+        // Indices must be normalized, i.e., already divided by VLEN_*.
+        ALWAYS_INLINE void writeVecNormMasked(const real_vec_t& v, real_vec_mask_t mask,
+                                              idx_t t, idx_t nv,
+                                              idx_t iv, idx_t jv, idx_t kv,
+                                              int line) {
+            idx_t n2 = getMatIndex(t, nv);
+            RealVecGrid_NXYZ<LayoutFn>::writeVecNormMasked(v, mask, n2, iv, jv, kv, line);
+        }
+
         // Get pointer to the real at t and offset n, i, j, k.
         ALWAYS_INLINE const real_t* getElemPtr(idx_t t, idx_t n, idx_t i, idx_t j, idx_t k,
                                              int line) const {
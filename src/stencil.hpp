@@ -75,6 +75,7 @@ IN THE SOFTWARE.
 #else
 #define MPI_PROC_NULL (-1)
 #define MPI_Barrier(comm)
+#define MPI_Abort(comm, err) exit(err)
 #define MPI_Comm int
 #endif
 
@@ -112,13 +113,23 @@ extern "C" {
 #define TRACE_MSG(fmt,...) ((void)0)
 #endif
 
+// Timeline tracing.
+#include "trace_buf.hpp"
+
 // Size of time dimension required in allocated memory.
-// TODO: calculate this per-grid based on dependency tree and
-// traversal order.
+// By default, each grid is allocated the number of time-step slots
+// calculated for it by the foldBuilder, and TIME_DIM_SIZE is the max
+// across grids. If TIME_DIM_SIZE is defined, all grids use it.
 // TODO: separate required time-step slots vs. those for
 // temp work areas.
-#ifndef TIME_DIM_SIZE
-#define TIME_DIM_SIZE (2)
+#ifndef MAX_TIME_SLOTS
+#define MAX_TIME_SLOTS (2)
+#endif
+#ifdef TIME_DIM_SIZE
+#define TIME_SLOTS(n) (TIME_DIM_SIZE)
+#else
+#define TIME_SLOTS(n) (n)
+#define TIME_DIM_SIZE MAX_TIME_SLOTS
 #endif
 
 // Cluster sizes in vectors.
@@ -161,11 +172,17 @@ extern "C" {
 #ifndef DEF_BLOCK_SIZE
 #define DEF_BLOCK_SIZE (64)
 #endif
+#ifndef DEF_BOUNDARY_WIDTH
+#define DEF_BOUNDARY_WIDTH (16)
+#endif
 
 // Memory-accessing code.
 #include "mem_macros.hpp"
 #include "realv_grids.hpp"
 
+// HW counters.
+#include "perf_counters.hpp"
+
 namespace yask {
 
 #ifdef MODEL_CACHE
@@ -78,7 +78,8 @@ namespace yask {
                                               stencil->get_name().c_str(), t, n, ix, iy, iz);
                             
                                     // Evaluate the reference scalar code.
-                                    stencil->calc_scalar(context, t, n, ix, iy, iz);
+                                    if (stencil->is_in_subdomain(ix, iy, iz))
+                                        stencil->calc_scalar(context, t, n, ix, iy, iz);
                                 }
                             }
                     }
@@ -91,6 +92,7 @@ namespace yask {
     // Eval stencil(s) over grid(s) using optimized code.
     void StencilEquations::calc_rank_opt(StencilContext& context)
     {
+        TRACE_SCOPE("rank", name.c_str());
         init(context);
 
         // Problem begin points.
@@ -120,33 +122,30 @@ namespace yask {
         idx_t step_dy = context.ry;
         idx_t step_dz = context.rz;
 
-        // Determine spatial skewing angles for temporal wavefronts based on the
-        // halos.  This assumes the smallest granularity of calculation is
-        // CPTS_* in each dim.
-        // We only need non-zero angles if the region size is less than the rank size,
-        // i.e., if the region covers the whole rank in a given dimension, no wave-front
-        // is needed in thar dim.
-        // TODO: make this grid-specific.
-        context.angle_n = (context.rn < context.dn) ? ROUND_UP(context.hn, CPTS_N) : 0;
-        context.angle_x = (context.rx < context.dx) ? ROUND_UP(context.hx, CPTS_X) : 0;
-        context.angle_y = (context.ry < context.dy) ? ROUND_UP(context.hy, CPTS_Y) : 0;
-        context.angle_z = (context.rz < context.dz) ? ROUND_UP(context.hz, CPTS_Z) : 0;
-        TRACE_MSG("wavefront angles: %ld, %ld, %ld, %ld",
-                  context.angle_n, context.angle_x, context.angle_y, context.angle_z);
-    
-        // Extend end points for overlapping regions due to wavefront angle.
-        // For each subsequent time step in a region, the spatial location of
-        // each block evaluation is shifted by the angle for each stencil. So,
-        // the total shift in a region is the angle * num stencils * num
-        // timesteps. Thus, the number of overlapping regions is ceil(total
-        // shift / region size).  This assumes stencils are inter-dependent.
-        // TODO: calculate stencil inter-dependency in the foldBuilder for each
-        // dimension.
-        idx_t nshifts = (idx_t(stencils.size()) * context.rt) - 1;
-        end_dn += context.angle_n * nshifts;
-        end_dx += context.angle_x * nshifts;
-        end_dy += context.angle_y * nshifts;
-        end_dz += context.angle_z * nshifts;
+        // Extend end points for overlapping regions due to wavefront angles.
+        // For each subsequent equation evaluation in a region, the spatial
+        // location of each block evaluation is shifted by the angle of that
+        // equation. So, the total shift in a region is the sum of the angles
+        // times the number of time steps, minus the angle of the first
+        // equation, which is not shifted. The angles are calculated by the
+        // foldBuilder from the inter-equation dependencies.
+        if (step_dt > 1 || fuse_eqs) {
+            idx_t sum_n = 0, sum_x = 0, sum_y = 0, sum_z = 0;
+            for (auto stencil : stencils) {
+                TRACE_MSG("wavefront angles for '%s': %ld, %ld, %ld, %ld",
+                          stencil->get_name().c_str(), stencil->angle_n,
+                          stencil->angle_x, stencil->angle_y, stencil->angle_z);
+                sum_n += stencil->angle_n;
+                sum_x += stencil->angle_x;
+                sum_y += stencil->angle_y;
+                sum_z += stencil->angle_z;
+            }
+            auto first = stencils.front();
+            end_dn += sum_n * step_dt - first->angle_n;
+            end_dx += sum_x * step_dt - first->angle_x;
+            end_dy += sum_y * step_dt - first->angle_y;
+            end_dz += sum_z * step_dt - first->angle_z;
+        }
         TRACE_MSG("virtual domain after wavefront adjustment: %ld..%ld, %ld..%ld, %ld..%ld, %ld..%ld, %ld..%ld", 
                   begin_dt, end_dt-1,
                   begin_dn, end_dn-1,
@@ -165,7 +164,7 @@ namespace yask {
 
             // If doing only one time step in a region (default), loop through equations here,
             // and do only one equation at a time in calc_region().
-            if (step_dt == 1) {
+            if (step_dt == 1 && !fuse_eqs) {
 
                 for (auto stencil : stencils) {
 
@@ -181,9 +180,8 @@ namespace yask {
                 }
             }
 
-            // If doing more than one time step in a region (temporal wave-front),
-            // must do all equations in calc_region().
-            // TODO: allow doing all equations in region even with one time step for testing.
+            // If doing more than one time step in a region (temporal wave-front)
+            // or fusing equations, must do all equations in calc_region().
             else {
 
                 StencilSet stencil_set;
@@ -219,6 +217,7 @@ namespace yask {
                   start_dx, stop_dx-1,
                   start_dy, stop_dy-1,
                   start_dz, stop_dz-1);
+        TRACE_SCOPE("region", 0);
 
         // Steps within a region are based on block sizes.
         const idx_t step_rt = context.bt;
@@ -238,6 +237,9 @@ namespace yask {
         // stepping by step_rt.
         const idx_t num_rt = ((stop_dt - start_dt) + (step_rt - 1)) / step_rt;
     
+        // No shift before the first equation evaluated in this region.
+        bool first = true;
+
         // Step through time steps in this region.
         for (idx_t index_rt = 0; index_rt < num_rt; index_rt++) {
         
@@ -253,6 +255,21 @@ namespace yask {
             for (auto stencil : stencils) {
                 if (stencil_set.count(stencil)) {
 
+                    // Shift spatial region boundaries for this equation to
+                    // implement temporal wavefront.  We only shift backward, so
+                    // region loops must increment. They may do so in any order.
+                    if (!first) {
+                        start_dn -= stencil->angle_n;
+                        stop_dn -= stencil->angle_n;
+                        start_dx -= stencil->angle_x;
+                        stop_dx -= stencil->angle_x;
+                        start_dy -= stencil->angle_y;
+                        stop_dy -= stencil->angle_y;
+                        start_dz -= stencil->angle_z;
+                        stop_dz -= stencil->angle_z;
+                    }
+                    first = false;
+
                     // Actual region boundaries must stay within rank domain.
                     idx_t begin_rn = max<idx_t>(start_dn, 0);
                     idx_t end_rn = min<idx_t>(stop_dn, context.dn);
@@ -285,19 +302,6 @@ namespace yask {
                         // Reset threads back to max.
                         context.set_max_threads();
                     }
-            
-                    // Shift spatial region boundaries for next iteration to
-                    // implement temporal wavefront.  We only shift backward, so
-                    // region loops must increment. They may do so in any order.
-                    start_dn -= context.angle_n;
-                    stop_dn -= context.angle_n;
-                    start_dx -= context.angle_x;
-                    stop_dx -= context.angle_x;
-                    start_dy -= context.angle_y;
-                    stop_dy -= context.angle_y;
-                    start_dz -= context.angle_z;
-                    stop_dz -= context.angle_z;
-
                 }            
             } // stencil equations.
         } // time.
@@ -319,18 +323,18 @@ namespace yask {
         // These are the grids that need their halos exchanged.
         auto eqGridPtrs = getEqGridPtrs();
 
+        // Optional stats.
+        auto hs = context.halo_stats;
+        if (hs)
+            hs->num_exchanges++;
+
         // TODO: put this loop inside visitNeighbors.
         for (size_t gi = 0; gi < eqGridPtrs.size(); gi++) {
 
-            // Get pointer to generic grid and derived type.
-            // TODO: Make this more general.
+            // Get pointer to generic grid.
+            // The number of time slots and the layout vary by grid, so the
+            // time index is mapped and the data are accessed by the grid itself.
             auto gp = eqGridPtrs[gi];
-#if USING_DIM_N
-            auto gpd = dynamic_cast<Grid_TNXYZ*>(gp);
-#else
-            auto gpd = dynamic_cast<Grid_TXYZ*>(gp);
-#endif
-            assert(gpd);
 
             // Determine halo sizes to be exchanged for this grid;
             // context.h* contains the max value across all grids.  The grid
@@ -339,13 +343,13 @@ namespace yask {
             // the minimum of these values as a conservative value. TODO:
             // Store the actual halo needed in each grid and use this.
 #if USING_DIM_N
-            idx_t hn = min(context.hn, gpd->get_pn());
+            idx_t hn = min(context.hn, gp->get_pn());
 #else
             idx_t hn = 0;
 #endif
-            idx_t hx = min(context.hx, gpd->get_px());
-            idx_t hy = min(context.hy, gpd->get_py());
-            idx_t hz = min(context.hz, gpd->get_pz());
+            idx_t hx = min(context.hx, gp->get_px());
+            idx_t hy = min(context.hy, gp->get_py());
+            idx_t hz = min(context.hz, gp->get_pz());
             
             // Array to store max number of request handles.
             MPI_Request reqs[StencilContext::Bufs::nBufDirs * context.neighborhood_size];
@@ -354,6 +358,7 @@ namespace yask {
             // Pack data and initiate non-blocking send/receive to/from all neighbors.
             TRACE_MSG("rank %i: exchange_halos: packing data for grid '%s'...",
                       context.my_rank, gp->get_name().c_str());
+            TRACE_BEGIN(pack_begin);
             context.bufs[gp].visitNeighbors
                 (context,
                  [&](idx_t nn, idx_t nx, idx_t ny, idx_t nz,
@@ -363,6 +368,7 @@ namespace yask {
                  {
                      // Pack and send data if buffer exists.
                      if (sendBuf) {
+                         double pack_start = hs ? getTimeInSecs() : 0.;
 
                          // Set begin/end vars to indicate what part
                          // of main grid to read from.
@@ -413,8 +419,8 @@ namespace yask {
 #define calc_halo(context, t,                                           \
                   start_nv, start_xv, start_yv, start_zv,               \
                   stop_nv, stop_xv, stop_yv, stop_zv)                   \
-                         real_vec_t hval = gpd->readVecNorm(t, ARG_N(start_nv) \
-                                                            start_xv, start_yv, start_zv, __LINE__); \
+                         real_vec_t hval = gp->readVecMat(gp->get_mat_index(t, start_nv), \
+                                                          start_xv, start_yv, start_zv, __LINE__); \
                          sendBuf->writeVecNorm(hval, index_nv,        \
                                                index_xv, index_yv, index_zv, __LINE__)
                          
@@ -423,6 +429,13 @@ namespace yask {
 #include "stencil_halo_loops.hpp"
 #undef calc_halo
 
+                         if (hs) {
+                             auto& ds = hs->dirs[nn][nx][ny][nz];
+                             ds.pack_secs += getTimeInSecs() - pack_start;
+                             ds.pack_bytes += sendBuf->get_num_bytes();
+                             ds.num_sends++;
+                         }
+
                          // Send filled buffer to neighbor.
                          const void* buf = (const void*)(sendBuf->getRawData());
                          MPI_Isend(buf, sendBuf->get_num_bytes(), MPI_BYTE,
@@ -439,15 +452,23 @@ namespace yask {
                      
                  } );
 
+            TRACE_END(pack_begin, "halo_pack", gp->get_name().c_str());
+
             // Wait for all to complete.
             // TODO: process each buffer asynchronously immediately upon completion.
             TRACE_MSG("rank %i: exchange_halos: waiting for %i MPI request(s)...",
                       context.my_rank, nreqs);
+            TRACE_BEGIN(wait_begin);
+            double wait_start = hs ? getTimeInSecs() : 0.;
             MPI_Waitall(nreqs, reqs, MPI_STATUS_IGNORE);
+            if (hs)
+                hs->wait_secs += getTimeInSecs() - wait_start;
+            TRACE_END(wait_begin, "halo_wait", gp->get_name().c_str());
             TRACE_MSG("rank %i: exchange_halos: done waiting for %i MPI request(s).",
                       context.my_rank, nreqs);
 
             // Unpack received data from all neighbors.
+            TRACE_BEGIN(unpack_begin);
             context.bufs[gp].visitNeighbors
                 (context,
                  [&](idx_t nn, idx_t nx, idx_t ny, idx_t nz,
@@ -457,6 +478,7 @@ namespace yask {
                  {
                      // Unpack data if buffer exists.
                      if (rcvBuf) {
+                         double unpack_start = hs ? getTimeInSecs() : 0.;
 
                          // Set begin/end vars to indicate what part
                          // of main grid's halo to write to.
@@ -524,15 +546,23 @@ namespace yask {
                   stop_nv, stop_xv, stop_yv, stop_zv)                   \
             real_vec_t hval = rcvBuf->readVecNorm(index_nv,             \
                                                   index_xv, index_yv, index_zv, __LINE__); \
-            gpd->writeVecNorm(hval, t, ARG_N(start_nv)                  \
-                              start_xv, start_yv, start_zv, __LINE__)
+            gp->writeVecMat(hval, gp->get_mat_index(t, start_nv),       \
+                            start_xv, start_yv, start_zv, __LINE__)
 
                          // Include auto-generated loops to invoke calc_halo() from
                          // begin_*v to end_*v;
 #include "stencil_halo_loops.hpp"
 #undef calc_halo
+
+                         if (hs) {
+                             auto& ds = hs->dirs[nn][nx][ny][nz];
+                             ds.unpack_secs += getTimeInSecs() - unpack_start;
+                             ds.unpack_bytes += rcvBuf->get_num_bytes();
+                             ds.num_recvs++;
+                         }
                      }
                  } );
+            TRACE_END(unpack_begin, "halo_unpack", gp->get_name().c_str());
 
         } // grids.
 #endif
@@ -551,6 +581,12 @@ namespace yask {
         cout << "Logical coordinates of rank " << my_rank << ": " <<
             mrnn << ", " << mrnx << ", " << mrny << ", " << mrnz << endl;
 
+        // Determine my offsets in the overall domain.
+        // All ranks are the same size.
+        ofs_x = mrnx * dx;
+        ofs_y = mrny * dy;
+        ofs_z = mrnz * dz;
+
         // Determine who my neighbors are.
         int num_neighbors = 0;
         for (int rn = 0; rn < num_ranks; rn++) {
@@ -659,6 +695,9 @@ namespace yask {
                 v += 0.01;
             }
         }
+        findInterior();
+        initInterior();
+        inputs_changed = true;
     }
 
     // Init all grids & params w/different values.
@@ -677,6 +716,36 @@ namespace yask {
                 v += 0.001;
             }
         }
+        findInterior();
+        initInterior();
+        inputs_changed = true;
+    }
+
+    // Set begin_i* and end_i* from bw, rank sizes, and neighbors.
+    // Sides shared with another rank are not part of the boundary,
+    // so the interior extends through the halo on those sides.
+    void StencilContext::findInterior() {
+        const int p = rank_prev, s = rank_self, n = rank_next;
+        begin_ix = (my_neighbors[s][p][s][s] == MPI_PROC_NULL) ? bw : -hx;
+        begin_iy = (my_neighbors[s][s][p][s] == MPI_PROC_NULL) ? bw : -hy;
+        begin_iz = (my_neighbors[s][s][s][p] == MPI_PROC_NULL) ? bw : -hz;
+        end_ix = dx + ((my_neighbors[s][n][s][s] == MPI_PROC_NULL) ? -bw : hx);
+        end_iy = dy + ((my_neighbors[s][s][n][s] == MPI_PROC_NULL) ? -bw : hy);
+        end_iz = dz + ((my_neighbors[s][s][s][n] == MPI_PROC_NULL) ? -bw : hz);
+    }
+
+    // Find the interior, verify its values, and compute derived values.
+    void StencilContext::setupInputs() {
+        findInterior();
+        idx_t errs = checkInterior();
+        if (errs) {
+            cerr << "Error: " << errs << " interior point(s) in rank " << my_rank <<
+                " differ from the values assumed by the stencil code;" 
+                " increase the boundary width (-bw) to cover them." << endl;
+            MPI_Abort(comm, 1);
+        }
+        initDerived();
+        inputs_changed = false;
     }
 
     // Compare grids in contexts.
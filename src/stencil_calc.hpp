@@ -59,12 +59,23 @@ namespace yask {
         idx_t bt, bn, bx, by, bz; // block size.
         idx_t hn, hx, hy, hz;     // spatial halos (max over grids as required by stencil).
         idx_t pn, px, py, pz;     // spatial padding (extra to avoid aliasing).
-        idx_t angle_n, angle_x, angle_y, angle_z; // temporal skewing angles.
+
+        // Interior of the rank domain, where grids with interior values
+        // (e.g., sponge factors) are known to be constant. The boundary
+        // width is only applied on sides that have no neighbor rank.
+        idx_t bw;                               // boundary width.
+        idx_t begin_ix, begin_iy, begin_iz;     // interior begin.
+        idx_t end_ix, end_iy, end_iz;           // interior end (one past last).
+
+        // Whether grid or param values have been set since the last
+        // setupInputs(). Set this after changing any input data.
+        bool inputs_changed;
 
         // MPI.
         MPI_Comm comm;
         int num_ranks, my_rank;   // MPI-assigned index.
         idx_t nrn, nrx, nry, nrz; // number of ranks in each dim.
+        idx_t ofs_x, ofs_y, ofs_z; // offsets of this rank in the overall domain.
 
         // A type to store ranks of all possible neighbors in all
         // directions, including diagonals.
@@ -139,6 +150,34 @@ namespace yask {
         // Only grids in eqGridPtrs will have buffers.
         std::map<RealVecGridBase*, Bufs> bufs;
 
+        // Halo-exchange statistics.
+        // These are only collected when halo_stats is set,
+        // e.g., by the halo benchmark.
+        struct HaloStats {
+
+            // Totals for one neighbor.
+            struct DirStats {
+                double pack_secs, unpack_secs;
+                idx_t pack_bytes, unpack_bytes; // bytes in buffers.
+                idx_t num_sends, num_recvs;
+            };
+            DirStats dirs[num_neighbors][num_neighbors][num_neighbors][num_neighbors];
+
+            // Totals for all neighbors.
+            double wait_secs;
+            idx_t num_exchanges;
+
+            HaloStats() {
+                clear();
+            }
+            void clear() {
+                memset(dirs, 0, sizeof(dirs));
+                wait_secs = 0.;
+                num_exchanges = 0;
+            }
+        };
+        HaloStats* halo_stats;
+
         // Threading.
         // Remember original number of threads avail.
         // We use this instead of omp_get_num_procs() so the user
@@ -182,7 +221,11 @@ namespace yask {
         }
 
         // Ctor, dtor.
-        StencilContext() : num_ranks(1), my_rank(0),
+        StencilContext() : bw(0),
+                           begin_ix(0), begin_iy(0), begin_iz(0),
+                           end_ix(0), end_iy(0), end_iz(0), inputs_changed(true),
+                           num_ranks(1), my_rank(0),
+                           ofs_x(0), ofs_y(0), ofs_z(0), halo_stats(0),
                            orig_max_threads(1), num_block_threads(1)
         {
             // Init my_neighbors to indicate no neighbor.
@@ -212,6 +255,30 @@ namespace yask {
         // Better for validation, but slower.
         virtual void initDiff();
 
+        // Set begin_i* and end_i* from bw, rank sizes, and neighbors.
+        virtual void findInterior();
+
+        // Set interior values of grids in test data.
+        // Called from initSame() and initDiff() only; real data
+        // is never overwritten.
+        virtual void initInterior() { }
+
+        // Return number of interior points whose grid values differ from
+        // the interior values assumed by the stencil code.
+        virtual idx_t checkInterior() { return 0; }
+
+        // Prepare input data for the time steps: find the interior and
+        // verify its values, exiting with an error if they do not match,
+        // then compute derived values. Called from calc_rank_opt() and
+        // calc_rank_ref() when inputs_changed is set; may also be called
+        // directly once all grid and param values are final.
+        virtual void setupInputs();
+
+        // Compute grids and params derived from time-invariant grids and
+        // params. Called from setupInputs(), so the derived values are
+        // always computed from the final input data.
+        virtual void initDerived() { }
+
         // Compare grids in contexts.
         // Params should not be written to, so they are not compared.
         // Return number of mis-compares.
@@ -224,10 +291,29 @@ namespace yask {
     // A pure-virtual class base for a stencil equation.
     struct StencilBase {
 
+        // Sub-domain where this equation is evaluated, in rank-local
+        // indices and clipped to the rank domain. Set by init().
+        idx_t begin_sx, begin_sy, begin_sz;
+        idx_t end_sx, end_sy, end_sz;
+
+        // Spatial shift before evaluating this equation in a temporal
+        // wavefront. Zero in dims where a region covers the rank. Set by init().
+        idx_t angle_n, angle_x, angle_y, angle_z;
+
         // ctor, dtor.
-        StencilBase() { }
+        StencilBase() :
+            begin_sx(0), begin_sy(0), begin_sz(0),
+            end_sx(0), end_sy(0), end_sz(0),
+            angle_n(0), angle_x(0), angle_y(0), angle_z(0) { }
         virtual ~StencilBase() { }
 
+        // Determine whether a point is in the sub-domain.
+        inline bool is_in_subdomain(idx_t x, idx_t y, idx_t z) const {
+            return x >= begin_sx && x < end_sx &&
+                y >= begin_sy && y < end_sy &&
+                z >= begin_sz && z < end_sz;
+        }
+
         // Get name of this equation.
         virtual const std::string& get_name() =0;
 
@@ -237,7 +323,7 @@ namespace yask {
         // Get list of grids updated by this equation.
         virtual std::vector<RealVecGridBase*>& getEqGridPtrs() = 0;
 
-        // Set eqGridPtrs.
+        // Set eqGridPtrs and sub-domain.
         virtual void init(StencilContext& generic_context) =0;
     
         // Calculate one scalar result at time t.
@@ -255,6 +341,48 @@ namespace yask {
         virtual void exchange_halos(StencilContext& generic_context, idx_t start_dt, idx_t stop_dt);
     };
 
+    // Element masks for a cluster that extends past the end of the rank
+    // domain or the sub-domain of an equation. The mask for the vector
+    // at position i, j, k in the cluster selects the elements that are
+    // inside the domain.
+    struct ClusterMask {
+        real_vec_mask_t mx[CLEN_X], my[CLEN_Y], mz[CLEN_Z];
+
+        // Set masks for the cluster at normalized indices xv, yv, zv
+        // in the domain from bx, by, bz to ex-1, ey-1, ez-1.
+        void set(idx_t xv, idx_t yv, idx_t zv,
+                 idx_t bx, idx_t by, idx_t bz,
+                 idx_t ex, idx_t ey, idx_t ez) {
+            for (int i = 0; i < CLEN_X; i++) mx[i] = 0;
+            for (int j = 0; j < CLEN_Y; j++) my[j] = 0;
+            for (int k = 0; k < CLEN_Z; k++) mz[k] = 0;
+            for (int n = 0; n < VLEN_N; n++)
+                for (int ie = 0; ie < VLEN_X; ie++)
+                    for (int je = 0; je < VLEN_Y; je++)
+                        for (int ke = 0; ke < VLEN_Z; ke++) {
+                            real_vec_mask_t bit = real_vec_mask_t(1) <<
+                                real_vec_t::get_elem_index(n, ie, je, ke);
+                            for (int i = 0; i < CLEN_X; i++) {
+                                idx_t x = (xv + i) * VLEN_X + ie;
+                                if (x >= bx && x < ex) mx[i] |= bit;
+                            }
+                            for (int j = 0; j < CLEN_Y; j++) {
+                                idx_t y = (yv + j) * VLEN_Y + je;
+                                if (y >= by && y < ey) my[j] |= bit;
+                            }
+                            for (int k = 0; k < CLEN_Z; k++) {
+                                idx_t z = (zv + k) * VLEN_Z + ke;
+                                if (z >= bz && z < ez) mz[k] |= bit;
+                            }
+                        }
+        }
+
+        // Get mask for the vector at position i, j, k in the cluster.
+        ALWAYS_INLINE real_vec_mask_t get(int i, int j, int k) const {
+            return mx[i] & my[j] & mz[k];
+        }
+    };
+
     // Collections of stencils.
     typedef std::vector<StencilBase*> StencilList;
     typedef std::set<StencilBase*> StencilSet;
@@ -281,6 +409,35 @@ namespace yask {
                      ARG_N(begin_cnv) begin_cxv, begin_cyv, begin_czv); \
     }
 
+    // Define methods to prime a pipeline and to calculate a cluster using
+    // it for the block loop over bvar, which is in the dim direction.
+    // Partial clusters still load the pipeline to keep it in sync.
+#define PIPE_CLUSTER_METHODS(bvar, dim)                                 \
+    ALWAYS_INLINE void                                                  \
+    prime_pipe_cluster_ ## bvar (typename StencilEquationClass::Pipe_ ## dim& pipe, \
+                                 ContextClass& context, idx_t ct,       \
+                                 idx_t begin_cnv, idx_t begin_cxv, idx_t begin_cyv, idx_t begin_czv, \
+                                 idx_t end_cnv, idx_t end_cxv, idx_t end_cyv, idx_t end_czv) { \
+        _stencil.prime_pipe_ ## dim(context, pipe, ct,                  \
+                                    ARG_N(begin_cnv) begin_cxv, begin_cyv, begin_czv); \
+    }                                                                   \
+    ALWAYS_INLINE void                                                  \
+    calc_pipe_cluster_ ## bvar (typename StencilEquationClass::Pipe_ ## dim& pipe, \
+                                ContextClass& context, idx_t ct,        \
+                                idx_t begin_cnv, idx_t begin_cxv, idx_t begin_cyv, idx_t begin_czv, \
+                                idx_t end_cnv, idx_t end_cxv, idx_t end_cyv, idx_t end_czv) { \
+        TRACE_MSG("%s.%s(%ld, %ld, %ld, %ld, %ld)",                     \
+                  get_name().c_str(), "calc_pipe_cluster_" #bvar, ct,  \
+                  begin_cnv, begin_cxv, begin_cyv, begin_czv);          \
+        _stencil.load_pipe_ ## dim(context, pipe, ct,                   \
+                                   ARG_N(begin_cnv) begin_cxv, begin_cyv, begin_czv); \
+        if (is_full_cluster(begin_cxv, begin_cyv, begin_czv))           \
+            _stencil.calc_pipe_cluster_ ## dim(context, pipe, ct,       \
+                                               ARG_N(begin_cnv) begin_cxv, begin_cyv, begin_czv); \
+        else                                                            \
+            calc_partial_cluster(context, ct, begin_cnv, begin_cxv, begin_cyv, begin_czv); \
+    }
+
     // A template that provides wrappers around a stencil-equation class created
     // by the foldBuilder. A template is used instead of inheritance for performance.
     // By using templates, the compiler can inline stencil code into loops and
@@ -320,6 +477,23 @@ namespace yask {
 
             // Call the generated code.
             _stencil.init(context);
+
+            // Get sub-domain and clip it to the rank domain.
+            _stencil.get_bounds(context, begin_sx, begin_sy, begin_sz,
+                                end_sx, end_sy, end_sz);
+            begin_sx = std::max<idx_t>(begin_sx, 0);
+            begin_sy = std::max<idx_t>(begin_sy, 0);
+            begin_sz = std::max<idx_t>(begin_sz, 0);
+            end_sx = std::max(std::min(end_sx, context.dx), begin_sx);
+            end_sy = std::max(std::min(end_sy, context.dy), begin_sy);
+            end_sz = std::max(std::min(end_sz, context.dz), begin_sz);
+
+            // Wavefront angles are only needed if the region size is less
+            // than the rank size.
+            angle_n = (context.rn < context.dn) ? _stencil.angle_n : 0;
+            angle_x = (context.rx < context.dx) ? _stencil.angle_x : 0;
+            angle_y = (context.ry < context.dy) ? _stencil.angle_y : 0;
+            angle_z = (context.rz < context.dz) ? _stencil.angle_z : 0;
         }
     
         // Calculate one scalar result.
@@ -344,17 +518,67 @@ namespace yask {
             TRACE_MSG("%s.calc_cluster(%ld, %ld, %ld, %ld, %ld)",
                       get_name().c_str(), ct, begin_cnv, begin_cxv, begin_cyv, begin_czv);
 
-            // The step vars are hard-coded in calc_block below, and there should
-            // never be a partial step at this level. So, we can assume one var and
-            // exactly CLEN_d steps in each given direction d are calculated in this
-            // function.  Thus, we can ignore the end_* vars in the calc function.
+            // The step vars are hard-coded in calc_block below, and blocks
+            // start on cluster boundaries, so the only partial steps at this
+            // level are at the end of the rank domain in x, y, and z. Full
+            // clusters ignore the end_* vars; partial ones, including those
+            // crossing the edge of the sub-domain, are calculated with writes
+            // masked to the sub-domain.
+            assert(end_cnv == begin_cnv + CLEN_N);
+            assert(end_cxv <= begin_cxv + CLEN_X);
+            assert(end_cyv <= begin_cyv + CLEN_Y);
+            assert(end_czv <= begin_czv + CLEN_Z);
+        
+            // Calculate results.
+            if (is_full_cluster(begin_cxv, begin_cyv, begin_czv))
+                _stencil.calc_cluster(context, ct, ARG_N(begin_cnv) begin_cxv, begin_cyv, begin_czv);
+            else
+                calc_partial_cluster(context, ct, begin_cnv, begin_cxv, begin_cyv, begin_czv);
+        }
+
+        // Same as calc_cluster(), but full clusters are calculated with
+        // interior values substituted for grids that have them.
+        // Called from calc_block() only for blocks in the interior.
+        ALWAYS_INLINE void
+        calc_interior_cluster (ContextClass& context, idx_t ct,
+                               idx_t begin_cnv, idx_t begin_cxv, idx_t begin_cyv, idx_t begin_czv,
+                               idx_t end_cnv, idx_t end_cxv, idx_t end_cyv, idx_t end_czv)
+        {
+            TRACE_MSG("%s.calc_interior_cluster(%ld, %ld, %ld, %ld, %ld)",
+                      get_name().c_str(), ct, begin_cnv, begin_cxv, begin_cyv, begin_czv);
             assert(end_cnv == begin_cnv + CLEN_N);
-            assert(end_cxv == begin_cxv + CLEN_X);
-            assert(end_cyv == begin_cyv + CLEN_Y);
-            assert(end_czv == begin_czv + CLEN_Z);
+            assert(end_cxv <= begin_cxv + CLEN_X);
+            assert(end_cyv <= begin_cyv + CLEN_Y);
+            assert(end_czv <= begin_czv + CLEN_Z);
         
             // Calculate results.
-            _stencil.calc_cluster(context, ct, ARG_N(begin_cnv) begin_cxv, begin_cyv, begin_czv);
+            if (is_full_cluster(begin_cxv, begin_cyv, begin_czv))
+                _stencil.calc_cluster_interior(context, ct, ARG_N(begin_cnv) begin_cxv, begin_cyv, begin_czv);
+            else
+                calc_partial_cluster(context, ct, begin_cnv, begin_cxv, begin_cyv, begin_czv);
+        }
+
+        // Determine whether the cluster at normalized indices xv, yv, zv
+        // is entirely inside the sub-domain.
+        ALWAYS_INLINE bool is_full_cluster(idx_t xv, idx_t yv, idx_t zv) const {
+            return xv * VLEN_X >= begin_sx && (xv + CLEN_X) * VLEN_X <= end_sx &&
+                yv * VLEN_Y >= begin_sy && (yv + CLEN_Y) * VLEN_Y <= end_sy &&
+                zv * VLEN_Z >= begin_sz && (zv + CLEN_Z) * VLEN_Z <= end_sz;
+        }
+
+        // Calculate results within a cluster that extends past the end of
+        // the rank domain or the sub-domain. Not inlined to keep the block
+        // loops small.
+        NEVER_INLINE void
+        calc_partial_cluster (ContextClass& context, idx_t ct,
+                              idx_t begin_cnv, idx_t begin_cxv, idx_t begin_cyv, idx_t begin_czv)
+        {
+            ClusterMask cmask;
+            cmask.set(begin_cxv, begin_cyv, begin_czv,
+                      begin_sx, begin_sy, begin_sz,
+                      end_sx, end_sy, end_sz);
+            _stencil.calc_cluster_masked(context, ct, ARG_N(begin_cnv)
+                                         begin_cxv, begin_cyv, begin_czv, cmask);
         }
 
         // Prefetch a cluster.
@@ -365,6 +589,14 @@ namespace yask {
         PREFETCH_CLUSTER_METHOD(prefetch_cluster_bxv, prefetch_cluster_x)
         PREFETCH_CLUSTER_METHOD(prefetch_cluster_byv, prefetch_cluster_y)
         PREFETCH_CLUSTER_METHOD(prefetch_cluster_bzv, prefetch_cluster_z)
+
+        // Calculate clusters with a pipeline.
+#if USING_DIM_N
+        PIPE_CLUSTER_METHODS(bnv, n)
+#endif
+        PIPE_CLUSTER_METHODS(bxv, x)
+        PIPE_CLUSTER_METHODS(byv, y)
+        PIPE_CLUSTER_METHODS(bzv, z)
     
         // Calculate results within a cache block.
         // This function implements the interface in the base class.
@@ -381,20 +613,36 @@ namespace yask {
                       begin_bx, end_bx-1,
                       begin_by, end_by-1,
                       begin_bz, end_bz-1);
+            TRACE_SCOPE("block", get_name().c_str());
+            PerfCounters::addThisThread();
 
             // Convert to a problem-specific context.
             auto context = dynamic_cast<ContextClass&>(generic_context);
 
+            // Restrict to the sub-domain; skip the block if it is outside.
+            // Blocks start on cluster boundaries, so the begin vars are
+            // rounded down to keep them there.
+            begin_bx = std::max(begin_bx, begin_sx / CPTS_X * CPTS_X);
+            begin_by = std::max(begin_by, begin_sy / CPTS_Y * CPTS_Y);
+            begin_bz = std::max(begin_bz, begin_sz / CPTS_Z * CPTS_Z);
+            end_bx = std::min(end_bx, end_sx);
+            end_by = std::min(end_by, end_sy);
+            end_bz = std::min(end_bz, end_sz);
+            if (begin_bx >= end_bx || begin_by >= end_by || begin_bz >= end_bz)
+                return;
+
             // Divide indices by vector lengths.
             // Begin/end vars shouldn't be negative, so '/' is ok.
+            // End vars are rounded up to include a partial vector
+            // at the end of the rank domain.
             const idx_t begin_bnv = begin_bn / VLEN_N;
             const idx_t begin_bxv = begin_bx / VLEN_X;
             const idx_t begin_byv = begin_by / VLEN_Y;
             const idx_t begin_bzv = begin_bz / VLEN_Z;
             const idx_t end_bnv = end_bn / VLEN_N;
-            const idx_t end_bxv = end_bx / VLEN_X;
-            const idx_t end_byv = end_by / VLEN_Y;
-            const idx_t end_bzv = end_bz / VLEN_Z;
+            const idx_t end_bxv = CEIL_DIV(end_bx, VLEN_X);
+            const idx_t end_byv = CEIL_DIV(end_by, VLEN_Y);
+            const idx_t end_bzv = CEIL_DIV(end_bz, VLEN_Z);
 
             // Vector-size steps are based on cluster lengths.
             // Using CLEN_* instead of CPTS_* because we want vector lengths.
@@ -410,9 +658,55 @@ namespace yask {
                 // Set threads for a block.
                 context.set_block_threads();
 
+                // Is this block in the interior, including the halos of
+                // the grids with interior values?
+                bool interior =
+                    begin_bx - context.interior_halo_x >= context.begin_ix &&
+                    begin_by - context.interior_halo_y >= context.begin_iy &&
+                    begin_bz - context.interior_halo_z >= context.begin_iz &&
+                    end_bx + context.interior_halo_x <= context.end_ix &&
+                    end_by + context.interior_halo_y <= context.end_iy &&
+                    end_bz + context.interior_halo_z <= context.end_iz;
+
+                // Pipelined loops declare a pipeline var and pass it to
+                // the pipelined calc functions. Interior values are not
+                // substituted in pipelined clusters.
+#define MAKE_PIPE_BNV typename StencilEquationClass::Pipe_n pipe_bnv
+#define MAKE_PIPE_BXV typename StencilEquationClass::Pipe_x pipe_bxv
+#define MAKE_PIPE_BYV typename StencilEquationClass::Pipe_y pipe_byv
+#define MAKE_PIPE_BZV typename StencilEquationClass::Pipe_z pipe_bzv
+#define prime_pipe_cluster_bnv(...) prime_pipe_cluster_bnv(pipe_bnv, __VA_ARGS__)
+#define prime_pipe_cluster_bxv(...) prime_pipe_cluster_bxv(pipe_bxv, __VA_ARGS__)
+#define prime_pipe_cluster_byv(...) prime_pipe_cluster_byv(pipe_byv, __VA_ARGS__)
+#define prime_pipe_cluster_bzv(...) prime_pipe_cluster_bzv(pipe_bzv, __VA_ARGS__)
+#define calc_pipe_cluster_bnv(...) calc_pipe_cluster_bnv(pipe_bnv, __VA_ARGS__)
+#define calc_pipe_cluster_bxv(...) calc_pipe_cluster_bxv(pipe_bxv, __VA_ARGS__)
+#define calc_pipe_cluster_byv(...) calc_pipe_cluster_byv(pipe_byv, __VA_ARGS__)
+#define calc_pipe_cluster_bzv(...) calc_pipe_cluster_bzv(pipe_bzv, __VA_ARGS__)
+
                 // Include automatically-generated loop code that calls calc_cluster()
                 // and optionally, the prefetch functions().
+                if (interior) {
+#define calc_cluster calc_interior_cluster
 #include "stencil_block_loops.hpp"
+#undef calc_cluster
+                }
+                else {
+#include "stencil_block_loops.hpp"
+                }
+
+#undef MAKE_PIPE_BNV
+#undef MAKE_PIPE_BXV
+#undef MAKE_PIPE_BYV
+#undef MAKE_PIPE_BZV
+#undef prime_pipe_cluster_bnv
+#undef prime_pipe_cluster_bxv
+#undef prime_pipe_cluster_byv
+#undef prime_pipe_cluster_bzv
+#undef calc_pipe_cluster_bnv
+#undef calc_pipe_cluster_bxv
+#undef calc_pipe_cluster_byv
+#undef calc_pipe_cluster_bzv
             }
         }
 
@@ -430,10 +724,18 @@ namespace yask {
         // List of all stencil equations.
         StencilList stencils;
 
-        StencilEquations() {}
+        // Whether to evaluate all equations in each region, even with one
+        // time step per region. The regions are skewed by the wavefront
+        // angles, so each region's grids are streamed once per step when
+        // they fit in cache. Set by the generated ctor.
+        bool fuse_eqs;
+
+        StencilEquations() : fuse_eqs(false) {}
         virtual ~StencilEquations() {}
 
         virtual void init(StencilContext& context) {
+            if (context.inputs_changed)
+                context.setupInputs();
             for (auto stencil : stencils)
                 stencil->init(context);
         }
@@ -0,0 +1,32 @@
+// Automatically generated code; do not edit.
+
+// Stencil:
+#define STENCIL_NAME "awp"
+#define STENCIL_IS_AWP (1)
+#define STENCIL_CONTEXT_TEMPLATE StencilContext_awp
+#define STENCIL_EQUATIONS_TEMPLATE StencilEquations_awp
+#define STENCIL_CONTEXT StencilContext_awp<>
+#define STENCIL_EQUATIONS StencilEquations_awp<StencilContext_awp<> >
+
+// Dimensions:
+#define USING_DIM_T (1)
+#define USING_DIM_X (1)
+#define USING_DIM_Y (1)
+#define USING_DIM_Z (1)
+
+// One vector fold: x=8 * y=1 * z=1
+#define VLEN_X (8)
+#define VLEN_Y (1)
+#define VLEN_Z (1)
+#define VLEN (8)
+#define VLEN_FIRST_DIM_IS_UNIT_STRIDE (1)
+#define USING_UNALIGNED_LOADS (0)
+
+// Cluster of vector folds: x=1 * y=1 * z=2
+#define CLEN_X (1)
+#define CLEN_Y (1)
+#define CLEN_Z (2)
+#define CLEN (2)
+
+// Max number of time-step slots needed by any grid.
+#define MAX_TIME_SLOTS (1)
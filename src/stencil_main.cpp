@@ -27,6 +27,9 @@ IN THE SOFTWARE.
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
+#include <sstream>
+#include <algorithm>
 
 // Stencil types.
 #include "stencil.hpp"
@@ -37,6 +40,13 @@ IN THE SOFTWARE.
 // Include auto-generated stencil code.
 #include "stencil_code.hpp"
 
+// Layouts that may be selected at run-time.
+#include "layout_choices.hpp"
+
+// Stringify the value of a macro.
+#define STR2(s) #s
+#define STR(s) STR2(s)
+
 using namespace std;
 using namespace yask;
 
@@ -46,6 +56,16 @@ using namespace yask;
 Cache cache(MODEL_CACHE);
 #endif
 
+// Name of main().
+// When kernels for more than one arch are linked into one executable,
+// each copy is renamed, and isa_dispatch.cpp provides main().
+#ifndef STENCIL_MAIN
+#define STENCIL_MAIN main
+#endif
+
+// Helpers are local so that more than one copy can be linked.
+namespace {
+
 // Fix bsize, if needed, to fit into rsize and be a multiple of mult.
 // Return number of blocks.
 idx_t findNumSubsets(idx_t& bsize, const string& bname,
@@ -55,11 +75,12 @@ idx_t findNumSubsets(idx_t& bsize, const string& bname,
     if (bsize > rsize) bsize = rsize;
     bsize = ROUND_UP(bsize, mult);
     idx_t nblks = (rsize + bsize - 1) / bsize;
-    idx_t rem = rsize % bsize;
+    idx_t rem = (nblks > 1) ? rsize % bsize : 0;
     idx_t nfull_blks = rem ? (nblks - 1) : nblks;
 
     cout << " In '" << dim << "' dimension, " << rname << " of size " <<
-        rsize << " is divided into " << nfull_blks << " " << bname << "(s) of size " << bsize;
+        rsize << " is divided into " << nfull_blks << " " << bname << "(s) of size " <<
+        min(bsize, rsize);
     if (rem)
         cout << " plus 1 remainder " << bname << " of size " << rem;
     cout << "." << endl;
@@ -72,66 +93,90 @@ idx_t findNumRegions(idx_t& rsize, idx_t dsize, idx_t mult, string dim) {
     return findNumSubsets(rsize, "region", dsize, "rank", mult, dim);
 }
 
-// Parse command-line args, run kernel, run validation if requested.
-int main(int argc, char** argv)
-{
-    SEP_PAUSE;
+// Two-sided 95% Student's t value for n samples.
+double tValue95(size_t n) {
+    static const double tvals[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    const size_t ntvals = sizeof(tvals) / sizeof(tvals[0]);
+    size_t df = n - 1;
+    if (df < 1)
+        return 0.0;
+    if (df <= ntvals)
+        return tvals[df - 1];
+    return 1.960;
+}
 
-    // MPI init.
-    int my_rank = 0;
-    int num_ranks = 1;
-#ifdef USE_MPI
-    MPI_Init(&argc, &argv);
-    MPI_Comm comm = MPI_COMM_WORLD;
-    MPI_Comm_rank(comm, &my_rank);
-    MPI_Comm_size(comm, &num_ranks);
-#else
-    MPI_Comm comm = 0;
-#endif
-    bool is_leader = my_rank == 0;
+// Summary statistics of a set of samples.
+struct TrialStats {
+    double min, max, median, mean, stddev, ci95;
+    TrialStats(vector<double> vals) {
+        size_t n = vals.size();
+        assert(n > 0);
+        sort(vals.begin(), vals.end());
+        min = vals.front();
+        max = vals.back();
+        median = (n % 2) ? vals[n/2] : (vals[n/2 - 1] + vals[n/2]) / 2.0;
+        mean = 0.0;
+        for (auto v : vals)
+            mean += v;
+        mean /= double(n);
+        double ss = 0.0;
+        for (auto v : vals)
+            ss += (v - mean) * (v - mean);
+        stddev = (n > 1) ? sqrt(ss / double(n - 1)) : 0.0;
+        ci95 = tValue95(n) * stddev / sqrt(double(n));
+    }
+};
+
+// Evict the caches by writing and reading a buffer that is larger
+// than the last-level cache.
+void flushCaches(vector<char>& buf) {
+    const idx_t n = buf.size();
+    char* p = buf.data();
+    static char val = 0;
+    val++;
+    idx_t sum = 0;
+#pragma omp parallel for reduction(+:sum)
+    for (idx_t i = 0; i < n; i += 64) {
+        p[i] = val;
+        sum += p[i];
+    }
+    if (sum == 0 && val != 0)
+        cout << "note: unexpected cache-flush result." << endl; // prevent removal.
+}
 
-    if (is_leader) {
-        cout << "Invocation:";
-        for (int i = 0; i < argc; i++)
-            cout << " " << argv[i];
-        cout << endl;
+// Name of a pair of layouts, e.g., "123:1234" for Layout_123 and Layout_1234.
+string layoutName(string layout_3d, string layout_4d) {
+    const string prefix = "Layout_";
+    for (auto lp : { &layout_3d, &layout_4d })
+        if (lp->compare(0, prefix.length(), prefix) == 0)
+            lp->erase(0, prefix.length());
+    return layout_3d + ":" + layout_4d;
+}
 
-#ifdef DEBUG
-        cout << "*** WARNING: binary compiled with DEBUG; ignore performance results.\n";
-#endif
-#if defined(NO_INTRINSICS) && (VLEN > 1)
-        cout << "*** WARNING: binary compiled with NO_INTRINSICS; ignore performance results.\n";
-#endif
-#ifdef MODEL_CACHE
-        cout << "*** WARNING: binary compiled with MODEL_CACHE; ignore performance results.\n";
-#endif
-#ifdef TRACE_MEM
-        cout << "*** WARNING: binary compiled with TRACE_MEM; ignore performance results.\n";
-#endif
-#ifdef TRACE_INTRINSICS
-        cout << "*** WARNING: binary compiled with TRACE_INTRINSICS; ignore performance results.\n";
-#endif
+// Names of layouts that may be selected at run-time.
+string layoutChoices() {
+    string names;
+#define ADD_LAYOUT_NAME(L3, L4)                  \
+    names += (names.length() ? ", " : "") + layoutName(#L3, #L4);
+    LAYOUT_CHOICES(ADD_LAYOUT_NAME)
+#undef ADD_LAYOUT_NAME
+    return names;
+}
 
-        cout << endl <<
-            "┌──────────────────────────────────────────┐\n"
-            "│  Y.A.S.K. ── Yet Another Stencil Kernel  │\n"
-            "│            https://01.org/yask           │\n"
-            "│    Intel Corporation, copyright 2016     │\n"
-            "└──────────────────────────────────────────┘\n"
-            "\nStencil name: " STENCIL_NAME << endl;
+// Parse command-line args, run kernel, run validation if requested.
+// ContextClass and EquationsClass are the generated classes
+// instantiated for the layout selected in main().
+template <typename ContextClass, typename EquationsClass>
+int runStencil(int argc, char** argv,
+               int my_rank, int num_ranks, MPI_Comm comm,
+               const string& layout)
+{
+    bool is_leader = my_rank == 0;
 
-    }
 
-    // Stagger init messages in time.
-    // TODO: create an MPI-safe I/O handler.
-    sleep(my_rank);
-    cout << endl;
-#ifdef USE_MPI
-    cout << "MPI rank " << my_rank << " of " << num_ranks << endl;
-#else
-    cout << "MPI not enabled." << endl;
-#endif
-    
     // options and their defaults.
     idx_t num_trials = 3; // number of trials.
     idx_t dt = 50;     // number of time-steps per trial.
@@ -141,11 +186,15 @@ int main(int argc, char** argv)
     idx_t bt = 1;                          // temporal block size.
     idx_t bn = 1, bx = DEF_BLOCK_SIZE, by = DEF_BLOCK_SIZE, bz = DEF_BLOCK_SIZE;  // size of cache blocks.
     idx_t pn = 0, px = DEF_PAD, py = DEF_PAD, pz = DEF_PAD; // padding.
+    idx_t bw = DEF_BOUNDARY_WIDTH;         // boundary width.
     idx_t nrn = 1, nrx = num_ranks, nry = 1, nrz = 1; // num ranks in each dim.
     bool validate = false;
     int  block_threads = DEF_BLOCK_THREADS; // number of threads for a block.
     bool doWarmup = true;
-    int pre_trial_sleep_time = 1;   // sec to sleep before each trial.
+    int max_warmups = 10;           // max warmup passes.
+    int warmup_tol = 5;             // % change in throughput between warmup passes.
+    bool cold_cache = false;        // flush caches before each trial.
+    int flush_mb = 0;               // MiB to write when flushing caches (0 => auto).
 
     // parse options.
     bool help = false;
@@ -177,6 +226,8 @@ int main(int argc, char** argv)
                     " -p{n,x,y,z} <n>  extra padding in specified spatial dimension, defaults=" <<
                     pn << '*' << px << '*' << py << '*' << pz << endl <<
                     " -p <n>           set same padding in 3 {x,y,z} spatial dimensions\n" <<
+                    " -bw <n>          width of boundary layer on outer sides of the overall domain, default=" <<
+                    bw << endl <<
 #ifdef USE_MPI
                     " -nr{n,x,y,z} <n> num ranks in specified spatial dimension, defaults=" <<
                     nrn << '*' << nrx << '*' << nry << '*' << nrz << endl <<
@@ -187,6 +238,15 @@ int main(int argc, char** argv)
                     block_threads << endl <<
                     " -v               validate by comparing to a scalar run\n" <<
                     " -nw              skip warmup\n" <<
+                    " -wmax <n>        max number of warmup passes, default=" <<
+                    max_warmups << endl <<
+                    " -wtol <n>        warmup is done when throughput changes by <= n percent, default=" <<
+                    warmup_tol << endl <<
+                    " -cold            flush caches before each trial\n" <<
+                    " -layout <3d>:<4d> grid layouts, default=" <<
+                    layoutName(STR(LAYOUT_3D), STR(LAYOUT_4D)) <<
+                    ", available=" << layoutChoices() << endl <<
+                    " -flush_mb <n>    MiB of memory written to flush caches, default=2*LLC size\n" <<
                     "Notes:\n"
 #ifndef USE_MPI
                     " This binary has not been built with MPI support.\n"
@@ -202,6 +262,7 @@ int main(int argc, char** argv)
                     " If validation fails, it may be due to rounding error; try building with 8-byte reals.\n"
                     " Validation disables warmup and sets the default number of trials to 1.\n"
                     " The 'n' dimension only applies to stencils that use that variable.\n"
+                    " Add layouts to those available w/-layout by building w/extra_layouts='<3d>:<4d> ...'.\n"
                     "Examples:\n" <<
                     " " << argv[0] << " -d 768 -dt 4\n" <<
                     " " << argv[0] << " -dx 512 -dy 256 -dz 128\n" <<
@@ -213,6 +274,8 @@ int main(int argc, char** argv)
 
             else if (opt == "-nw")
                 doWarmup = false;
+            else if (opt == "-cold")
+                cold_cache = true;
 
             // validation.
             else if (opt == "-v") {
@@ -220,6 +283,15 @@ int main(int argc, char** argv)
                 num_trials = 1;
             }
 
+            // layout was already selected in main().
+            else if (opt == "-layout") {
+                if (argi + 1 >= argc) {
+                    cerr << "error: no value for option '" << opt << "'." << endl;
+                    exit(1);
+                }
+                argi++;
+            }
+
             // options w/int values.
             else {
 
@@ -252,6 +324,7 @@ int main(int argc, char** argv)
                 else if (opt == "-py") py = val;
                 else if (opt == "-pz") pz = val;
                 else if (opt == "-p") px = py = pz = val;
+                else if (opt == "-bw") bw = val;
 #ifdef USE_MPI
                 else if (opt == "-nrn") nrn = val;
                 else if (opt == "-nrx") nrx = val;
@@ -260,6 +333,9 @@ int main(int argc, char** argv)
                 else if (opt == "-nr") nrx = nry = nrz = val;
 #endif
                 else if (opt == "-bthreads") block_threads = val;
+                else if (opt == "-wmax") max_warmups = val;
+                else if (opt == "-wtol") warmup_tol = val;
+                else if (opt == "-flush_mb") flush_mb = val;
                 else {
                     cerr << "error: option '" << opt << "' not recognized." << endl;
                     exit(1);
@@ -292,11 +368,14 @@ int main(int argc, char** argv)
     }
     
     // Context for evaluating results.
-    STENCIL_CONTEXT context;
+    ContextClass context;
     context.num_ranks = num_ranks;
     context.my_rank = my_rank;
     context.comm = comm;
 
+    // Stencil equations to evaluate.
+    EquationsClass stencils;
+
     // report threads.
     {
         cout << endl;
@@ -344,7 +423,9 @@ int main(int argc, char** argv)
     }
 
     // Adjust defaults for wavefronts.
-    if (rt != 1) {
+    // Fused equations are also skewed, and regions must be smaller than
+    // the rank for the grids to stay in cache between equations.
+    if (rt != 1 || stencils.fuse_eqs) {
         if (!rn) rn = 1;
         if (!rx) rx = DEF_WAVEFRONT_REGION_SIZE;
         if (!ry) ry = DEF_WAVEFRONT_REGION_SIZE;
@@ -352,16 +433,28 @@ int main(int argc, char** argv)
 
         // TODO: enable this.
         if (num_ranks > 1) {
-            cerr << "Sorry, MPI communication is not currently enabled with wave-front tiling." << endl;
+            cerr << "Error: MPI communication is not currently enabled with " <<
+                (stencils.fuse_eqs ? "fused equations" : "wave-front tiling") <<
+                "; use one rank." << endl;
+#ifdef USE_MPI
+            MPI_Finalize();
+#endif
+            exit(1);
         }
     }
 
     // Round up vars as needed.
     dt = roundUp(dt, CPTS_T, "rank size in t (time steps)");
     dn = roundUp(dn, CPTS_N, "rank size in n");
-    dx = roundUp(dx, CPTS_X, "rank size in x");
-    dy = roundUp(dy, CPTS_Y, "rank size in y");
-    dz = roundUp(dz, CPTS_Z, "rank size in z");
+
+    // Sizes in x, y, and z need not be multiples of the cluster sizes
+    // because partial clusters are calculated with masked writes.
+    // Halos are exchanged in whole vectors, though.
+    if (num_ranks > 1) {
+        dx = roundUp(dx, VLEN_X, "rank size in x");
+        dy = roundUp(dy, VLEN_Y, "rank size in y");
+        dz = roundUp(dz, VLEN_Z, "rank size in z");
+    }
 
     // Determine num regions based on region sizes.
     // Also fix up region sizes as needed.
@@ -412,11 +505,15 @@ int main(int argc, char** argv)
         " overall-size: " << dt << '*' << dn << '*' << (dx * num_ranks) << '*' << dy << '*' << dz << endl;
     cout << "\nOther settings:\n"
         " num-ranks: " << nrn << '*' << nrx << '*' << nry << '*' << nrz << endl <<
+        " arch: " STR(ARCH_NAME) << endl <<
         " stencil-shape: " STENCIL_NAME << endl << 
+        " layouts: " << layout << endl <<
+        " fuse-equations: " << stencils.fuse_eqs << endl <<
         " time-dim-size: " << TIME_DIM_SIZE << endl <<
         " vector-len: " << VLEN << endl <<
         " padding: " << pn << '+' << px << '+' << py << '+' << pz << endl <<
         " max-halos: " << hn << '+' << hx << '+' << hy << '+' << hz << endl <<
+        " boundary-width: " << bw << endl <<
         " manual-L1-prefetch-distance: " << PFDL1 << endl <<
         " manual-L2-prefetch-distance: " << PFDL2 << endl;
 
@@ -453,6 +550,7 @@ int main(int argc, char** argv)
     context.hx = hx;
     context.hy = hy;
     context.hz = hz;
+    context.bw = bw;
 
     context.nrn = nrn;
     context.nrx = nrx;
@@ -478,7 +576,6 @@ int main(int argc, char** argv)
 
     // Stencil functions.
     idx_t scalar_fp_ops = 0;
-    STENCIL_EQUATIONS stencils;
     idx_t num_stencils = stencils.stencils.size();
     cout << endl;
     cout << "Num stencil equations: " << num_stencils << endl <<
@@ -550,12 +647,14 @@ int main(int argc, char** argv)
     MPI_Barrier(comm);
     
     // warmup caches, threading, etc.
+    // Repeat until the throughput is stable.
     if (doWarmup) {
         if (is_leader) cout << endl;
 
         // Temporarily set dt to a temp value.
         idx_t tmp_dt = min<idx_t>(dt, TIME_DIM_SIZE);
         context.dt = tmp_dt;
+        const idx_t warmup_numpts = tmp_dt * grids_numpts;
 
 #ifdef MODEL_CACHE
         if (!is_leader)
@@ -564,17 +663,39 @@ int main(int argc, char** argv)
             cout << "Modeling cache...\n";
 #endif
         if (is_leader)
-            cout << "Warmup of " << context.dt << " time step(s)...\n" << flush;
-        stencils.calc_rank_opt(context);
+            cout << "Warmup of up to " << max_warmups << " pass(es) of " <<
+                context.dt << " time step(s) each...\n" << flush;
+        double prev_pps = 0.0;
+        for (int wi = 0; wi < max_warmups; wi++) {
+            MPI_Barrier(comm);
+            double wpstart = getTimeInSecs();
+            stencils.calc_rank_opt(context);
+            MPI_Barrier(comm);
+            double wpps = double(warmup_numpts) / (getTimeInSecs() - wpstart);
 
 #ifdef MODEL_CACHE
-        // print cache stats, then disable.
-        if (cache.isEnabled()) {
-            cout << "Done modeling cache...\n";
-            cache.dumpStats();
-            cache.disable();
-        }
+            // print cache stats, then disable.
+            if (cache.isEnabled()) {
+                cout << "Done modeling cache...\n";
+                cache.dumpStats();
+                cache.disable();
+            }
+#endif
+
+            // Stable if rank throughput changed by no more than the tolerance.
+            // Use the leader's decision so all ranks do the same passes.
+            int stable = (wi > 0 &&
+                          fabs(wpps - prev_pps) <= prev_pps * warmup_tol / 100.0) ? 1 : 0;
+#ifdef USE_MPI
+            MPI_Bcast(&stable, 1, MPI_INT, 0, comm);
 #endif
+            if (is_leader)
+                cout << " pass " << (wi + 1) << " throughput (points/sec): " <<
+                    printWithPow10Multiplier(wpps) << (stable ? " (stable)" : "") << endl;
+            prev_pps = wpps;
+            if (stable)
+                break;
+        }
 
         // Replace temp setting with correct value.
         context.dt = dt;
@@ -585,6 +706,40 @@ int main(int argc, char** argv)
     // variables for measuring performance.
     double wstart, wstop;
     float best_elapsed_time=0.0f, best_pps=0.0f, best_flops=0.0f;
+    vector<double> trial_pps;
+
+    // Buffer for flushing caches.
+    vector<char> flush_buf;
+    if (cold_cache) {
+        size_t flush_bytes = size_t(flush_mb) * 1024 * 1024;
+        if (!flush_bytes) {
+#ifdef _SC_LEVEL3_CACHE_SIZE
+            long llc_bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+            if (llc_bytes > 0)
+                flush_bytes = 2 * size_t(llc_bytes);
+#endif
+            if (!flush_bytes)
+                flush_bytes = size_t(256) * 1024 * 1024;
+        }
+        flush_buf.resize(flush_bytes);
+        if (is_leader)
+            cout << "\nCaches will be flushed before each trial by writing " <<
+                printWithPow2Multiplier(flush_bytes) << "B." << endl;
+    }
+
+    // Open counters for the threads used in the trials.
+    PerfCounters::open(context);
+    if (is_leader) {
+        cout << "\nPerformance counters: ";
+        if (PerfCounters::getKind() == PerfCounters::no_counters)
+            cout << "not available" << endl;
+        else {
+            cout << (PerfCounters::getKind() == PerfCounters::hw_counters ? "hardware" : "software") << " (";
+            for (int ci = 0; ci < PerfCounters::num_counters; ci++)
+                cout << (ci ? ", " : "") << PerfCounters::getName(ci);
+            cout << ") on " << PerfCounters::getNumThreads() << " thread(s)" << endl;
+        }
+    }
 
     // Performance runs.
     if (is_leader) {
@@ -597,15 +752,20 @@ int main(int argc, char** argv)
         if (validate)
             context.initDiff();
 
-        sleep(pre_trial_sleep_time);
+        if (cold_cache)
+            flushCaches(flush_buf);
         MPI_Barrier(comm);
         SEP_RESUME;
         wstart = getTimeInSecs();
+        TRACE_BEGIN(trial_begin);
+        PerfCounters::start();
 
         // Actual work.
         stencils.calc_rank_opt(context);
         
         MPI_Barrier(comm);
+        PerfCounters::stop();
+        TRACE_END(trial_begin, "trial", 0);
         SEP_PAUSE;
         wstop =  getTimeInSecs();
             
@@ -618,6 +778,7 @@ int main(int argc, char** argv)
                 "time (sec):              " << printWithPow10Multiplier(elapsed_time) << endl <<
                 "throughput (points/sec): " << printWithPow10Multiplier(pps) << endl <<
                 "throughput (est FLOPS):  " << printWithPow10Multiplier(flops) << endl;
+            PerfCounters::print(cout, grids_rank_numpts);
         }
 
         if (pps > best_pps) {
@@ -625,13 +786,23 @@ int main(int argc, char** argv)
             best_elapsed_time = elapsed_time;
             best_flops = flops;
         }
+        trial_pps.push_back(double(tot_numpts) / (wstop - wstart));
     }
 
     if (is_leader) {
+        TrialStats stats(trial_pps);
         cout << "-----------------------------------------\n" <<
             "best-time (sec):              " << printWithPow10Multiplier(best_elapsed_time) << endl <<
             "best-throughput (points/sec): " << printWithPow10Multiplier(best_pps) << endl <<
             "best-throughput (est FLOPS):  " << printWithPow10Multiplier(best_flops) << endl <<
+            "-----------------------------------------\n" <<
+            "num-trials:                     " << trial_pps.size() << endl <<
+            "median-throughput (points/sec): " << printWithPow10Multiplier(stats.median) << endl <<
+            "mean-throughput (points/sec):   " << printWithPow10Multiplier(stats.mean) << endl <<
+            "stddev-throughput (points/sec): " << printWithPow10Multiplier(stats.stddev) << endl <<
+            "95%-CI-throughput (points/sec): " << printWithPow10Multiplier(stats.mean - stats.ci95) <<
+            " to " << printWithPow10Multiplier(stats.mean + stats.ci95) << endl <<
+            "min-throughput (points/sec):    " << printWithPow10Multiplier(stats.min) << endl <<
             "-----------------------------------------\n";
     }
     
@@ -644,7 +815,7 @@ int main(int argc, char** argv)
 
         // Make a ref context for comparisons w/new grids:
         // Copy the settings from context, then re-alloc grids.
-        STENCIL_CONTEXT ref = context;
+        ContextClass ref = context;
         ref.name += "-reference";
         ref.allocGrids();
         ref.allocParams();
@@ -687,6 +858,15 @@ int main(int argc, char** argv)
     else if (is_leader)
         cout << "\nRESULTS NOT VERIFIED.\n";
 
+#ifdef TRACE_BUF
+    // Write timeline from this rank.
+    {
+        ostringstream fname;
+        fname << "yask_trace." << my_rank << ".json";
+        TraceBuf::dump(fname.str(), my_rank);
+    }
+#endif
+
 #ifdef USE_MPI
     MPI_Barrier(comm);
     MPI_Finalize();
@@ -696,3 +876,89 @@ int main(int argc, char** argv)
     
     return 0;
 }
+
+} // anonymous namespace.
+
+// Select the layouts and run the kernel.
+int STENCIL_MAIN(int argc, char** argv)
+{
+    SEP_PAUSE;
+
+    // MPI init.
+    int my_rank = 0;
+    int num_ranks = 1;
+#ifdef USE_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm comm = MPI_COMM_WORLD;
+    MPI_Comm_rank(comm, &my_rank);
+    MPI_Comm_size(comm, &num_ranks);
+#else
+    MPI_Comm comm = 0;
+#endif
+    bool is_leader = my_rank == 0;
+
+    if (is_leader) {
+        cout << "Invocation:";
+        for (int i = 0; i < argc; i++)
+            cout << " " << argv[i];
+        cout << endl;
+
+#ifdef DEBUG
+        cout << "*** WARNING: binary compiled with DEBUG; ignore performance results.\n";
+#endif
+#if defined(NO_INTRINSICS) && (VLEN > 1)
+        cout << "*** WARNING: binary compiled with NO_INTRINSICS; ignore performance results.\n";
+#endif
+#ifdef MODEL_CACHE
+        cout << "*** WARNING: binary compiled with MODEL_CACHE; ignore performance results.\n";
+#endif
+#ifdef TRACE_MEM
+        cout << "*** WARNING: binary compiled with TRACE_MEM; ignore performance results.\n";
+#endif
+#ifdef TRACE_INTRINSICS
+        cout << "*** WARNING: binary compiled with TRACE_INTRINSICS; ignore performance results.\n";
+#endif
+
+        cout << endl <<
+            "┌──────────────────────────────────────────┐\n"
+            "│  Y.A.S.K. ── Yet Another Stencil Kernel  │\n"
+            "│            https://01.org/yask           │\n"
+            "│    Intel Corporation, copyright 2016     │\n"
+            "└──────────────────────────────────────────┘\n"
+            "\nStencil name: " STENCIL_NAME << endl;
+
+    }
+
+    // Stagger init messages in time.
+    // TODO: create an MPI-safe I/O handler.
+    sleep(my_rank);
+    cout << endl;
+#ifdef USE_MPI
+    cout << "MPI rank " << my_rank << " of " << num_ranks << endl;
+#else
+    cout << "MPI not enabled." << endl;
+#endif
+    
+    // Find the requested layouts; other options are parsed in runStencil().
+    string layout = layoutName(STR(LAYOUT_3D), STR(LAYOUT_4D));
+    for (int argi = 1; argi + 1 < argc; argi++)
+        if (string(argv[argi]) == "-layout") {
+            string val = argv[argi + 1];
+            size_t sep = val.find(':');
+            layout = (sep == string::npos) ? val :
+                layoutName(val.substr(0, sep), val.substr(sep + 1));
+        }
+
+    // Run the kernel instantiated for the requested layouts.
+#define RUN_LAYOUT(L3, L4)                                              \
+    if (layout == layoutName(#L3, #L4))                                 \
+        return runStencil<STENCIL_CONTEXT_TEMPLATE<L3, L4>,             \
+                          STENCIL_EQUATIONS_TEMPLATE<STENCIL_CONTEXT_TEMPLATE<L3, L4> > > \
+            (argc, argv, my_rank, num_ranks, comm, layout);
+    LAYOUT_CHOICES(RUN_LAYOUT)
+#undef RUN_LAYOUT
+
+    cerr << "error: layout '" << layout << "' is not available; choose from " <<
+        layoutChoices() << " or rebuild with extra_layouts='" << layout << "'." << endl;
+    exit(1);
+}
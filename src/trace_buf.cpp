@@ -0,0 +1,111 @@
+/*****************************************************************************
+
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2016, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+#include "stencil.hpp"
+
+#ifdef TRACE_BUF
+
+#include <time.h>
+#include <fstream>
+#include <mutex>
+
+using namespace std;
+namespace yask {
+
+    // All buffers created so far, indexed by tid.
+    static vector<TraceBuf*> all_bufs;
+    static mutex all_bufs_lock;
+
+    // Time of first call, used to make timestamps relative.
+    static uint64_t trace_start_ns = TraceBuf::now_ns();
+
+    uint64_t TraceBuf::now_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ULL + uint64_t(ts.tv_nsec);
+    }
+
+    TraceBuf* TraceBuf::get() {
+        static thread_local TraceBuf* tb = 0;
+        if (!tb) {
+            lock_guard<mutex> lock(all_bufs_lock);
+            tb = new TraceBuf(int(all_bufs.size()));
+            all_bufs.push_back(tb);
+        }
+        return tb;
+    }
+
+    void TraceBuf::dump(const string& fname, int rank) {
+        lock_guard<mutex> lock(all_bufs_lock);
+
+        ofstream os(fname.c_str());
+        if (!os) {
+            cerr << "error: cannot write trace to '" << fname << "'." << endl;
+            return;
+        }
+        os << "{\"traceEvents\":[";
+        bool first = true;
+        uint64_t num_events = 0, num_lost = 0;
+        os.precision(3);
+        os << fixed;
+        for (auto tb : all_bufs) {
+
+            // Thread name.
+            os << (first ? "\n" : ",\n") <<
+                "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << rank <<
+                ",\"tid\":" << tb->_tid <<
+                ",\"args\":{\"name\":\"thread " << tb->_tid << "\"}}";
+            first = false;
+
+            // Events in order from oldest to newest.
+            uint64_t n = tb->_num_events;
+            uint64_t nkept = min<uint64_t>(n, TRACE_BUF_SIZE);
+            num_events += nkept;
+            num_lost += n - nkept;
+            for (uint64_t i = n - nkept; i < n; i++) {
+                const TraceEvent& ev = tb->_events[i % TRACE_BUF_SIZE];
+
+                // Chrome 'complete' events use microsecs.
+                os << ",\n{\"name\":\"" << ev.name <<
+                    "\",\"ph\":\"X\",\"pid\":" << rank <<
+                    ",\"tid\":" << tb->_tid <<
+                    ",\"ts\":" << (double(ev.begin_ns - trace_start_ns) * 1e-3) <<
+                    ",\"dur\":" << (double(ev.end_ns - ev.begin_ns) * 1e-3);
+                if (ev.detail)
+                    os << ",\"args\":{\"detail\":\"" << ev.detail << "\"}";
+                os << "}";
+            }
+        }
+        os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+
+        cout << "Wrote " << num_events << " trace event(s) from " <<
+            all_bufs.size() << " thread(s) to '" << fname << "'." << endl;
+        if (num_lost)
+            cout << "Note: " << num_lost << " older trace event(s) were overwritten; "
+                "increase TRACE_BUF_SIZE to keep them." << endl;
+    }
+}
+
+#endif
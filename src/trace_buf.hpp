@@ -0,0 +1,123 @@
+/*****************************************************************************
+
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2016, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+// Low-overhead timeline tracing.
+// Build with TRACE_BUF defined (make trace_buf=1) to record begin/end
+// times of rank, region, block, and halo-exchange calls in a per-thread
+// ring buffer. Unlike TRACE_MSG, recording an event does not do any I/O
+// or take any locks, so the timeline is not distorted by the tracing.
+// The buffers are written out as Chrome trace-event JSON by
+// TraceBuf::dump(), which may be viewed in chrome://tracing or
+// https://ui.perfetto.dev.
+
+#ifndef TRACE_BUF_HPP
+#define TRACE_BUF_HPP
+
+#ifdef TRACE_BUF
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Max number of events kept per thread.
+// Oldest events are overwritten when the buffer is full.
+#ifndef TRACE_BUF_SIZE
+#define TRACE_BUF_SIZE (1 << 16)
+#endif
+
+namespace yask {
+
+    // One timed event.
+    struct TraceEvent {
+        const char* name;       // must be a static string.
+        const char* detail;     // optional; must outlive the trace.
+        uint64_t begin_ns, end_ns;
+    };
+
+    // Ring buffer of events for one thread.
+    class TraceBuf {
+    protected:
+        std::vector<TraceEvent> _events;
+        uint64_t _num_events;   // total ever added; may exceed size of _events.
+        int _tid;               // sequential id assigned on first use.
+
+        TraceBuf(int tid) :
+            _events(TRACE_BUF_SIZE), _num_events(0), _tid(tid) { }
+
+    public:
+
+        // Get buffer for the calling thread, creating it if needed.
+        static TraceBuf* get();
+
+        // Current time in nanosecs from a monotonic clock.
+        static uint64_t now_ns();
+
+        // Add an event.
+        inline void add(const char* name, const char* detail,
+                        uint64_t begin_ns, uint64_t end_ns) {
+            TraceEvent& ev = _events[_num_events % TRACE_BUF_SIZE];
+            ev.name = name;
+            ev.detail = detail;
+            ev.begin_ns = begin_ns;
+            ev.end_ns = end_ns;
+            _num_events++;
+        }
+
+        // Write events from all threads to fname.
+        // Must not be called while any thread is adding events.
+        static void dump(const std::string& fname, int rank);
+    };
+
+    // Record an event from construction to destruction.
+    class TraceScope {
+        const char* _name;
+        const char* _detail;
+        uint64_t _begin_ns;
+
+    public:
+        TraceScope(const char* name, const char* detail = 0) :
+            _name(name), _detail(detail), _begin_ns(TraceBuf::now_ns()) { }
+        ~TraceScope() {
+            TraceBuf::get()->add(_name, _detail, _begin_ns, TraceBuf::now_ns());
+        }
+    };
+}
+
+// Trace from here to the end of the enclosing scope.
+#define TRACE_SCOPE(name, detail) yask::TraceScope trace_scope(name, detail)
+
+// Trace from TRACE_BEGIN(var) to TRACE_END(var, ...) in the same scope.
+#define TRACE_BEGIN(var) const uint64_t var = yask::TraceBuf::now_ns()
+#define TRACE_END(var, name, detail) \
+    yask::TraceBuf::get()->add(name, detail, var, yask::TraceBuf::now_ns())
+
+#else
+
+#define TRACE_SCOPE(name, detail) ((void)0)
+#define TRACE_BEGIN(var) ((void)0)
+#define TRACE_END(var, name, detail) ((void)0)
+
+#endif
+#endif
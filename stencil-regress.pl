@@ -0,0 +1,252 @@
+#! /usr/bin/env perl
+#-*-Perl-*- This line forces emacs to use Perl mode.
+
+##############################################################################
+## YASK: Yet Another Stencil Kernel
+## Copyright (c) 2014-2016, Intel Corporation
+## 
+## Permission is hereby granted, free of charge, to any person obtaining a copy
+## of this software and associated documentation files (the "Software"), to
+## deal in the Software without restriction, including without limitation the
+## rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+## sell copies of the Software, and to permit persons to whom the Software is
+## furnished to do so, subject to the following conditions:
+## 
+## * The above copyright notice and this permission notice shall be included in
+##   all copies or substantial portions of the Software.
+## 
+## THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+## IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+## FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+## AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+## LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+## FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+## IN THE SOFTWARE.
+
+# Purpose: Build and run a fixed set of stencil cases and compare their
+# throughput against stored baselines for this machine.
+
+BEGIN {
+    if ($0 =~ m{/}) { ($MYHOME) = $0 =~ m{(.*)/} }
+    else { $MYHOME = '.' }
+}
+use lib $MYHOME;
+use lib "$MYHOME/lib";
+
+use strict;
+use warnings;
+
+use File::Basename;
+use File::Path qw(make_path);
+use Sys::Hostname;
+use CmdLine;
+
+$| = 1;                         # autoflush.
+
+my %OPT;                        # cmd-line options.
+
+# Convert a number printed by printWithPow10Multiplier() to a value.
+sub getVal($) {
+    my $str = shift;
+    my %mults = ( K => 1e3, M => 1e6, G => 1e9 );
+    return undef if !defined $str || $str !~ /^\s*([-+0-9.eE]+)\s*([KMG]?)/;
+    my ($num, $mult) = ($1, $2);
+    return $num * ($mult ? $mults{$mult} : 1);
+}
+
+# Read cases file.
+# Each non-comment line contains 3 '|'-separated fields:
+# name | make args | executable args.
+sub readCases($) {
+    my $fname = shift;
+    my @cases;
+    open my $fh, '<', $fname or die "error: cannot read '$fname': $!\n";
+    while (<$fh>) {
+        chomp;
+        s/#.*//;
+        next if /^\s*$/;
+        my @fields = map { s/^\s+|\s+$//g; $_ } split /\|/;
+        die "error: expected 'name | make args | exe args' in '$fname' line $.\n"
+            if @fields != 3;
+        push @cases, { name => $fields[0], make => $fields[1], args => $fields[2] };
+    }
+    close $fh;
+    return @cases;
+}
+
+# Read baselines: name => { median, stddev, n }.
+sub readBaselines($) {
+    my $fname = shift;
+    my %base;
+    return %base if !-e $fname;
+    open my $fh, '<', $fname or die "error: cannot read '$fname': $!\n";
+    while (<$fh>) {
+        chomp;
+        next if /^\s*#/ || /^\s*$/;
+        my ($name, $median, $stddev, $n) = split;
+        $base{$name} = { median => $median, stddev => $stddev, n => $n };
+    }
+    close $fh;
+    return %base;
+}
+
+sub writeBaselines($$) {
+    my ($fname, $base) = @_;
+    make_path(dirname($fname));
+    open my $fh, '>', $fname or die "error: cannot write '$fname': $!\n";
+    print $fh "# YASK performance baselines for '$OPT{machine}' arch=$OPT{arch}.\n",
+        "# Written by $0 on ".localtime().".\n",
+        "# name median-points/sec stddev-points/sec num-trials\n";
+    for my $name (sort keys %$base) {
+        my $b = $base->{$name};
+        printf $fh "%s %.6g %.6g %d\n", $name, $b->{median}, $b->{stddev}, $b->{n};
+    }
+    close $fh;
+    print "Baselines written to '$fname'.\n";
+}
+
+# Build and run one case.
+# Return { median, stddev, n } or undef on failure.
+sub runCase($) {
+    my $case = shift;
+    my $log = "$OPT{logDir}/$case->{name}.log";
+    make_path($OPT{logDir});
+
+    my $make = "make clean >> $log 2>&1 && ".
+        "make arch=$OPT{arch} $case->{make} $OPT{makeArgs} >> $log 2>&1";
+    my $run = "$OPT{runPrefix} ./stencil.$OPT{arch}.exe $case->{args} $OPT{runArgs} >> $log 2>&1";
+    unlink $log;
+    for my $cmd ($make, $run) {
+        print " $cmd\n" if $OPT{verbose};
+        if (system($cmd) != 0) {
+            warn "error: '$case->{name}' failed; see '$log'.\n";
+            return undef;
+        }
+    }
+
+    # Get stats printed by stencil_main.cpp.
+    my %res;
+    open my $fh, '<', $log or die "error: cannot read '$log': $!\n";
+    while (<$fh>) {
+        $res{median} = getVal($1) if /^median-throughput \(points\/sec\):\s*(\S+)/;
+        $res{stddev} = getVal($1) if /^stddev-throughput \(points\/sec\):\s*(\S+)/;
+        $res{n} = $1 if /^num-trials:\s*(\d+)/;
+    }
+    close $fh;
+    if (!defined $res{median}) {
+        warn "error: no throughput found for '$case->{name}'; see '$log'.\n";
+        return undef;
+    }
+    $res{stddev} //= 0;
+    $res{n} //= 1;
+    return \%res;
+}
+
+# Compare one result to its baseline.
+# A slow-down is a regression only if it is larger than the tolerance
+# AND larger than 2 standard errors of the difference, i.e., it is
+# both meaningful and unlikely to be noise.
+sub compare($$) {
+    my ($base, $res) = @_;
+    return ('new', 0) if !defined $base;
+    my $diff = $res->{median} - $base->{median};
+    my $pct = 100.0 * $diff / $base->{median};
+    my $se = sqrt(($base->{stddev} ** 2) / $base->{n} +
+                  ($res->{stddev} ** 2) / $res->{n});
+    my $significant = abs($diff) > 2 * $se;
+    return ('SLOWER', $pct) if $pct < -$OPT{tol} && $significant;
+    return ('faster', $pct) if $pct > $OPT{tol} && $significant;
+    return ('ok', $pct);
+}
+
+sub main() {
+
+    my(@KNOBS) =
+        ( # knob,        description,   optional default
+          [ "arch=s", "Target architecture, as used in the Makefile.", 'knl'],
+          [ "cases=s", "File listing the cases to run.", "$::MYHOME/regress-cases.txt"],
+          [ "machine=s", "Name of this machine for selecting baselines.", (split /\./, hostname())[0]],
+          [ "baseDir=s", "Directory containing baseline files.", "$::MYHOME/regress-baselines"],
+          [ "logDir=s", "Directory for build and run logs.", "regress-logs"],
+          [ "tol=f", "Percent slow-down allowed before reporting a regression.", 5],
+          [ "makeArgs=s", "Additional args for every make command.", ''],
+          [ "runArgs=s", "Additional args for every executable.", ''],
+          [ "runPrefix=s", "Command to prefix every executable, e.g., 'numactl --preferred=1'.", ''],
+          [ "only=s", "Regex to select a subset of case names.", ''],
+          [ "update!", "Save the results as the new baselines instead of comparing.", 0],
+        );
+    my($command_line) = process_command_line(\%OPT, \@KNOBS);
+    print "$command_line\n" if $OPT{verbose};
+
+    my $script = basename($0);
+    if (!$command_line || $OPT{help}) {
+        print "Runs performance-regression cases and compares points/sec to baselines.\n",
+            "Usage: $script [options]\n",
+            "Examples:\n",
+            "  $script -arch=skx -update   # create baselines for this machine.\n",
+            "  $script -arch=skx           # compare to baselines.\n",
+            "  $script -arch=skx -only=awp # compare only matching cases.\n",
+            "The median of the trials in each case is compared to the baseline median.\n",
+            "Exits with a non-zero status if any case fails or is slower than the baseline.\n",
+            "Options:\n";
+        print_options_help(\@KNOBS);
+        exit 1;
+    }
+
+    my $baseFile = "$OPT{baseDir}/$OPT{machine}-$OPT{arch}.txt";
+    my %base = readBaselines($baseFile);
+    my @cases = readCases($OPT{cases});
+    @cases = grep { $_->{name} =~ /$OPT{only}/ } @cases if $OPT{only} ne '';
+    die "error: no cases selected.\n" if !@cases;
+    if (!$OPT{update} && !%base) {
+        warn "warning: no baselines in '$baseFile'; run with -update to create them.\n";
+    }
+
+    # Run all cases.
+    my (%results, @failed);
+    for my $case (@cases) {
+        print "Running '$case->{name}'...\n";
+        my $res = runCase($case);
+        if ($res) {
+            $results{$case->{name}} = $res;
+        } else {
+            push @failed, $case->{name};
+        }
+    }
+
+    if ($OPT{update}) {
+        %base = (%base, %results);
+        writeBaselines($baseFile, \%base);
+        return @failed ? 1 : 0;
+    }
+
+    # Print table.
+    my $nregress = 0;
+    my $fmt = "%-20s %14s %14s %9s  %s\n";
+    print "\nResults for '$OPT{machine}' arch=$OPT{arch} (points/sec, median):\n";
+    printf $fmt, 'case', 'baseline', 'current', 'change', 'status';
+    printf $fmt, '-' x 20, '-' x 14, '-' x 14, '-' x 9, '-' x 6;
+    for my $case (@cases) {
+        my $name = $case->{name};
+        my $b = $base{$name};
+        my $res = $results{$name};
+        if (!$res) {
+            printf $fmt, $name, $b ? sprintf("%.4g", $b->{median}) : '-', '-', '-', 'FAILED';
+            next;
+        }
+        my ($status, $pct) = compare($b, $res);
+        $nregress++ if $status eq 'SLOWER';
+        printf $fmt, $name,
+            $b ? sprintf("%.4g", $b->{median}) : '-',
+            sprintf("%.4g", $res->{median}),
+            $b ? sprintf("%+.1f%%", $pct) : '-',
+            $status;
+    }
+    print "\n";
+    print scalar(@failed)." case(s) failed to build or run.\n" if @failed;
+    print "$nregress case(s) slower than baseline by more than $OPT{tol}%.\n" if $nregress;
+    print "No regressions found.\n" if !@failed && !$nregress;
+    return (@failed || $nregress) ? 1 : 0;
+}
+
+exit main();